@@ -30,6 +30,9 @@ main(int argc, char *argv[])
 CQSudokuApp::
 CQSudokuApp()
 {
+  // log solve steps to stderr
+  sudoku_.setEventSink(&log_sink_);
+
   QFrame *frame = new QFrame();
 
   QVBoxLayout *frame_layout   = new QVBoxLayout;
@@ -92,11 +92,12 @@ class CQSudokuApp {
   }
 
  private:
-  CSudoku           sudoku_;
-  CQSudokuCanvas   *canvas_;
-  CQSudokuLineEdit *line_edit_;
-  int               edit_x_, edit_y_;
-  QStatusBar       *status_bar_;
+  CSudoku              sudoku_;
+  CSudokuTextEventSink log_sink_;
+  CQSudokuCanvas      *canvas_;
+  CQSudokuLineEdit    *line_edit_;
+  int                  edit_x_, edit_y_;
+  QStatusBar          *status_bar_;
 };
 
 class CQSudokuLineEdit : public QLineEdit {
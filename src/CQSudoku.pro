@@ -2,19 +2,38 @@ TEMPLATE = app
 
 QT += widgets
 
+CONFIG += c++14
+
 TARGET = CQSudoku
 
 DEPENDPATH += .
 
 #CONFIG += debug
 
+# collect solver strategy statistics (CSudokuStats.h)
+#DEFINES += CSUDOKU_STATS
+
 # Input
 SOURCES += \
 CSudoku.cpp \
+CSudokuEvents.cpp \
+CSudokuGenerator.cpp \
+CSudokuDLX.cpp \
+CSudokuBitBoard.cpp \
+CSudokuPack.cpp \
+CSudokuThreadPool.cpp \
 CQSudoku.cpp
 
 HEADERS += \
 CSudoku.h \
+CSudokuEvents.h \
+CSudokuGenerator.h \
+CSudokuRating.h \
+CSudokuStats.h \
+CSudokuDLX.h \
+CSudokuBitBoard.h \
+CSudokuPack.h \
+CSudokuThreadPool.h \
 CQSudoku.h \
 
 DESTDIR     = ../bin
@@ -1,8 +1,18 @@
 #include <CSudoku.h>
+#include <CSudokuDLX.h>
+#include <CSudokuGenerator.h>
+#include <CSudokuBitBoard.h>
+#include <CSudokuPack.h>
+#include <CSudokuThreadPool.h>
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
 
 #include <cstring>
 #include <cstdlib>
-#include <sstream>
+#include <cstdint>
 #include <iostream>
 
 CSudoku::Values exampleValues1 = {{
@@ -33,272 +43,792 @@ CSudoku::Values exampleValues2 = {{
   0, 7, 0,  4, 0, 0,  0, 3, 0,
 }};
 
-CSudoku::
-CSudoku() :
- valid_(true), log_(false)
-{
-  CellIterator pc1, pc2;
+// precalculated cell indices for each unit (rows, cols then blocks), the peers
+// of each cell and the units (row, col, block) containing each cell
+template<uint N>
+struct CSudokuTablesT {
+  typedef CSudokuT<N> Sudoku;
+
+  enum { SIZE      = Sudoku::SIZE      };
+  enum { CELL_SIZE = Sudoku::CELL_SIZE };
+  enum { AREA      = Sudoku::AREA      };
+  enum { NUM_UNITS = Sudoku::NUM_UNITS };
+  enum { NUM_PEERS = Sudoku::NUM_PEERS };
+
+  // smallest type which can hold a cell index
+  typedef typename std::conditional<(AREA <= 256), uint8_t, ushort>::type Index;
+
+  Index   units     [NUM_UNITS][SIZE];
+  Index   peers     [AREA][NUM_PEERS];
+  uint8_t cell_units[AREA][3];
+
+  constexpr CSudokuTablesT() :
+   units(), peers(), cell_units() {
+    uint unit_size[NUM_UNITS] = {};
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+    for (uint k = 0; k < AREA; ++k) {
+      uint i = k / SIZE;
+      uint j = k % SIZE;
+
+      cell_units[k][0] = uint8_t(i);
+      cell_units[k][1] = uint8_t(SIZE + j);
+      cell_units[k][2] = uint8_t(2*SIZE + (i / CELL_SIZE) + CELL_SIZE*(j / CELL_SIZE));
+
+      for (uint n = 0; n < 3; ++n) {
+        uint u = cell_units[k][n];
+
+        units[u][unit_size[u]++] = Index(k);
+      }
+    }
 
-    cell.setPos(pc1.i(), pc1.j());
+    // peers are the other cells of the row and col then the block cells
+    // not already added from the row or col
+    for (uint k = 0; k < AREA; ++k) {
+      uint i = k / SIZE;
+      uint j = k % SIZE;
+
+      uint num_peers = 0;
+
+      for (uint n = 0; n < 3; ++n) {
+        uint u = cell_units[k][n];
+
+        for (uint m = 0; m < SIZE; ++m) {
+          uint k1 = units[u][m];
+
+          if (k1 == k) continue;
+
+          if (n == 2 && (k1 / SIZE == i || k1 % SIZE == j)) continue;
+
+          peers[k][num_peers++] = Index(k1);
+        }
+      }
+    }
   }
+};
+
+template<uint N>
+constexpr CSudokuTablesT<N> sudokuTables;
+
+//------
+
+template<uint N>
+CSudokuT<N>::
+CSudokuT() :
+ valid_(true), log_(false), engine_(ENGINE_STRATEGY), num_threads_(1),
+ game_clues_(0), num_nodes_(0), cancel_(NULL), sink_(NULL)
+{
+  resetValues();
+
+  memset(init_values_    , 0, sizeof(init_values_    ));
+  memset(solution_values_, 0, sizeof(solution_values_));
+}
+
+// out of line as thread pool is incomplete in header
+template<uint N>
+CSudokuT<N>::
+~CSudokuT()
+{
 }
 
+template<uint N>
 uint
-CSudoku::
+CSudokuT<N>::
 getValue(uint x, uint y) const
 {
-  return getCell(x, y).getValue();
+  return values_[x*SIZE + y];
 }
 
+template<uint N>
 void
-CSudoku::
+CSudokuT<N>::
 setValue(uint x, uint y, uint value)
 {
-  getCell(x, y).setValue(value);
+  assert(value <= SIZE);
+
+  uint k = x*SIZE + y;
+
+  // placing value in unknown cell only needs the cell's peers updating
+  if (values_[k] == 0 && value != 0) {
+    bool valid = placeValue(k, value);
+
+    valid_ = (valid_ && valid);
+
+    return;
+  }
+
+  // changing or clearing a value needs all possible values recalculating
+  values_[k] = uint8_t(value);
 
   valid_ = checkValid();
 }
 
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
 isSolveValue(uint x, uint y, uint v) const
 {
   return getCell(x, y).isSolveValue(v);
 }
 
+template<uint N>
 uint
-CSudoku::
+CSudokuT<N>::
 getSolvedValue(uint x, uint y) const
 {
   return getCell(x, y).getSolvedValue();
 }
 
+template<uint N>
 uint
-CSudoku::
+CSudokuT<N>::
 getSolutionValue(uint x, uint y) const
 {
-  return getCell(x, y).getSolutionValue();
+  return solution_values_[x*SIZE + y];
 }
 
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
 getIsInitUnknown(uint x, uint y) const
 {
-  return getCell(x, y).isInitUnknown();
+  return (init_values_[x*SIZE + y] == 0);
 }
 
+template<uint N>
 void
-CSudoku::
+CSudokuT<N>::
 newGame()
 {
+  CSUDOKU_STATS_RESET();
+
   Values values;
 
-  if (genValues(values))
-    init(values);
-  else
-    init(exampleValues1);
+  genValues(values);
+
+  init(values);
 
   setInitValues();
 
   initSolution();
 }
 
-void
-CSudoku::
+template<uint N>
+bool
+CSudokuT<N>::
 loadGame(const char *str)
 {
-  Values values;
+  return loadGame(str, strlen(str));
+}
+
+// load from string of len chars (need not be NUL terminated)
+template<uint N>
+bool
+CSudokuT<N>::
+loadGame(const char *str, size_t len)
+{
+  CSUDOKU_STATS_RESET();
 
-  auto len = strlen(str);
+  Values values;
 
-  for (uint i = 0; i < AREA; ++i) {
-    if (i < len && str[i] >= '1' && str[i] <= '9')
-      values.values[i] = uint(str[i] - '0');
-    else
-      values.values[i] = 0;
-  }
+  for (uint i = 0; i < AREA; ++i)
+    values.values[i] = (i < len ? charValue(str[i]) : 0);
 
   init(values);
 
   setInitValues();
 
-  initSolution();
+  return initSolution();
 }
 
-void
-CSudoku::
-reset()
+template<uint N>
+bool
+CSudokuT<N>::
+loadGame(const CSudokuPackReader &reader, ulong i)
 {
-  Values values;
+  if (reader.getCellSize() != N)
+    return false;
+
+  uint8_t values[AREA], solution[AREA];
+
+  if (! reader.read(i, values, solution))
+    return false;
+
+  CSUDOKU_STATS_RESET();
+
+  Values values1;
+
+  for (uint k = 0; k < AREA; ++k)
+    values1.values[k] = values[k];
+
+  init(values1);
+
+  setInitValues();
+
+  if (! valid_) {
+    memcpy(solution_values_, values_, sizeof(solution_values_));
+
+    return false;
+  }
+
+  if (! reader.hasSolutions())
+    return initSolution();
+
+  // stored solution must keep givens and use each value once per unit (else
+  // solve puzzle)
+  Mask unit_values[NUM_UNITS] = {};
 
-  CellIterator pc1, pc2;
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] && values_[k] != solution[k])
+      return initSolution();
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    const Cell &cell = *pc1;
+    Mask mask = ValueSet::valueMask(solution[k]);
 
-    values.values[pc1.k()] = (! cell.isInitUnknown() ? cell.getInitValue() : 0);
+    for (uint n = 0; n < 3; ++n) {
+      uint u = sudokuTables<N>.cell_units[k][n];
+
+      if (unit_values[u] & mask)
+        return initSolution();
+
+      unit_values[u] = Mask(unit_values[u] | mask);
+    }
   }
 
+  memcpy(solution_values_, solution, sizeof(solution_values_));
+
+  return true;
+}
+
+template<uint N>
+bool
+CSudokuT<N>::
+writeGame(CSudokuPackWriter &writer, uint difficulty) const
+{
+  if (writer.getCellSize() != N)
+    return false;
+
+  return writer.write(init_values_, solution_values_, difficulty);
+}
+
+template<uint N>
+void
+CSudokuT<N>::
+reset()
+{
+  CSUDOKU_STATS_RESET();
+
+  Values values;
+
+  for (uint k = 0; k < AREA; ++k)
+    values.values[k] = init_values_[k];
+
   init(values);
 
   initSolution();
 }
 
+template<uint N>
 void
-CSudoku::
+CSudokuT<N>::
 setInitValues()
 {
-  CellIterator pc1, pc2;
-
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
-
-    if (! cell.isUnknown())
-      cell.setInitValue(cell.getValue());
-    else
-      cell.resetInitValue();
-  }
+  memcpy(init_values_, values_, sizeof(init_values_));
 }
 
+template<uint N>
 void
-CSudoku::
+CSudokuT<N>::
 print()
 {
-  CellIterator pc1, pc2;
+  for (uint k = 0; k < AREA; ++k)
+    std::cout << valueChar(values_[k]);
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    const Cell &cell = *pc1;
+  std::cout << std::endl;
+}
 
-    uint value = cell.getValue();
+// values above 9 are written as letters (A is 10) for larger grids
+template<uint N>
+uint
+CSudokuT<N>::
+charValue(char c)
+{
+  uint value = 0;
 
-    std::cout << char(value + '0');
-  }
+  if      (c >= '1' && c <= '9') value = uint(c - '0');
+  else if (c >= 'A' && c <= 'Z') value = uint(c - 'A') + 10;
+  else if (c >= 'a' && c <= 'z') value = uint(c - 'a') + 10;
 
-  std::cout << std::endl;
+  return (value <= SIZE ? value : 0);
 }
 
-bool
-CSudoku::
+template<uint N>
+char
+CSudokuT<N>::
+valueChar(uint value)
+{
+  return char(value < 10 ? '0' + value : 'A' + value - 10);
+}
+
+template<uint N>
+void
+CSudokuT<N>::
 genValues(Values &values)
 {
-  enum { NUM_ITERATIONS = 50   };
-  enum { MAX_TRIES      = 1000 };
+  // generator is reseeded from rand() for each game (so follows srand())
+  static thread_local CSudokuGeneratorT<N> generator(1);
 
-  // reset values
-  CellIterator pc1, pc2;
+  generator.setSeed(((uint64_t(rand()) << 31) ^ uint64_t(rand())) + 1);
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  // random solved grid
+  uint8_t grid[AREA];
 
-    cell.resetValue();
+  generator.genGrid(grid);
 
-    values.values[pc1.k()] = 0;
-  }
+  // remove values in random order
+  uint cells[AREA];
+
+  for (uint k = 0; k < AREA; ++k)
+    cells[k] = k;
+
+  generator.shuffleValues(cells, AREA);
+
+  removeClues(grid, cells);
+
+  for (uint k = 0; k < AREA; ++k)
+    values.values[k] = grid[k];
+}
+
+// remove values of solved grid in specified cell order keeping each removal
+// which leaves a unique solution until game clues are left (or no more can be
+// removed, so every clue left is needed).
+//
+// Removals are checked in batches of one per thread. A removal which leaves
+// more than one solution is never possible later (removing values can't add
+// constraints) so its value is kept. While most removals succeed each batch
+// check removes the cells of the batch up to and including its own (so the
+// longest unique prefix is removed at once), otherwise each cell is checked on
+// its own and only the first unique removal is made (the batch's later unique
+// removals are checked again).
+template<uint N>
+void
+CSudokuT<N>::
+removeClues(uint8_t *values, const uint *cells)
+{
+  // removal whose uniqueness check needs more search nodes than this is
+  // treated as leaving more than one solution (so large puzzles may not be
+  // minimal but generation finishes). 25x25 nodes are slow and near minimal
+  // checks can need tens of millions.
+  enum { MAX_CHECK_NODES = (N == 5 ? 1<<14 : 1<<20) };
+
+  // search engine (strategy engine is too slow for generation)
+  Engine engine = (engine_ == ENGINE_DLX ? ENGINE_DLX : ENGINE_BITBOARD);
+
+  uint num_threads = std::max(num_threads_, 1U);
 
-  uint n = 0;
-  uint i = 0;
+  CSudokuThreadPool *pool = (num_threads > 1 ? &threadPool() : NULL);
 
-  while (n < NUM_ITERATIONS) {
-    // get random value and position
-    uint value = uint((rand() % SIZE) + 1);
-    uint pos   = uint(rand() % AREA);
+  std::deque<uint> pending(cells, cells + AREA);
 
-    // ensure position is unknown
-    while (values.values[pos] != 0)
-      pos = uint(rand() % AREA);
+  uint num_clues = AREA;
 
-    // set to value
-    values.values[pos] = value;
+  bool prefix = true;
 
-    Cell &cell = getCell(pos);
+  std::vector<uint> batch;
+  std::vector<char> unique;
 
-    cell.setValue(value);
+  std::atomic<ulong> num_nodes(0);
 
-    // check if valid (if not reset and try again)
-    if (! checkValid()) {
-      values.values[pos] = 0;
+  while (! pending.empty() && num_clues > game_clues_) {
+    batch.clear();
 
-      cell.resetValue();
+    uint batch_size = std::min(num_threads, num_clues - game_clues_);
+
+    while (! pending.empty() && batch.size() < batch_size) {
+      batch.push_back(pending.front());
+
+      pending.pop_front();
     }
-    else
-      ++n;
 
-    // ensure we don't loop forever
-    ++i;
+    unique.assign(batch.size(), 0);
 
-    if (i > MAX_TRIES)
-      break;
-  }
+    auto checkRemoval = [&](uint b) {
+      uint8_t values1[AREA];
 
-  //------
+      memcpy(values1, values, AREA);
 
-  // set grid to calculated values
-  init(values);
+      if (prefix) {
+        for (uint b1 = 0; b1 <= b; ++b1)
+          values1[batch[b1]] = 0;
+      }
+      else
+        values1[batch[b]] = 0;
 
-  // remove cells until solvable
-  i = 0;
+      ulong num_nodes1 = 0;
 
-  while (! solvable()) {
-    // count number of solved cells
-    uint count = 0;
+      unique[b] = (solveValues(values1, NULL, 2, engine, num_nodes1, MAX_CHECK_NODES) == 1);
 
-    for (uint ia = 0; ia < AREA; ++ia)
-      if (values.values[ia] != 0)
-        ++count;
+      num_nodes += num_nodes1;
+    };
 
-    // too few values so give up
-    if (count < SIZE)
-      return false;
+    if (pool) {
+      for (uint b = 0; b < batch.size(); ++b)
+        pool->submit([&, b](uint) { checkRemoval(b); });
+
+      pool->wait();
+    }
+    else {
+      for (uint b = 0; b < batch.size(); ++b)
+        checkRemoval(b);
+    }
+
+    uint num_unique = 0;
+
+    if (prefix) {
+      // remove unique prefix (smaller prefixes are unique when larger one is).
+      // Removal after prefix fails and later cells are checked again.
+      uint b = 0;
+
+      for ( ; b < batch.size() && unique[b]; ++b)
+        values[batch[b]] = 0;
+
+      num_unique = b;
 
-    // reset random cell to unknown (0) and try again
-    uint pos = uint(rand() % AREA);
+      num_clues -= num_unique;
 
-    while (values.values[pos] == 0)
-      pos = uint(rand() % AREA);
+      if (b + 1 < batch.size())
+        pending.insert(pending.begin(), batch.begin() + b + 1, batch.end());
+    }
+    else {
+      std::vector<uint> recheck;
+
+      for (uint b = 0; b < batch.size(); ++b) {
+        if (! unique[b]) continue;
+
+        if (num_unique == 0) {
+          values[batch[b]] = 0;
 
-    values.values[pos] = 0;
+          --num_clues;
+        }
+        else
+          recheck.push_back(batch[b]);
 
-    init(values);
+        ++num_unique;
+      }
+
+      pending.insert(pending.begin(), recheck.begin(), recheck.end());
+    }
+
+    prefix = (2*num_unique > batch.size());
   }
 
-  return true;
+  num_nodes_ += num_nodes;
 }
 
+template<uint N>
 void
-CSudoku::
+CSudokuT<N>::
 init(const Values &values)
 {
-  // set cells from array of values
-  CellIterator pc1, pc2;
+  // reset cells and used values
+  resetValues();
+
+  // place cells from array of values
+  bool valid = true;
+
+  for (uint k = 0; k < AREA; ++k) {
+    uint value = values.values[k];
+
+    if (value && ! placeValue(k, value))
+      valid = false;
+  }
+
+  valid_ = valid;
+}
+
+template<uint N>
+void
+CSudokuT<N>::
+resetValues()
+{
+  memset(values_, 0, sizeof(values_));
+
+  for (uint k = 0; k < AREA; ++k)
+    solve_values_[k] = ValueSet::ALL_MASK;
+
+  for (uint u = 0; u < NUM_UNITS; ++u)
+    unit_used_[u] = 0;
+
+  trail_.clear();
+}
+
+template<uint N>
+bool
+CSudokuT<N>::
+placeValue(uint k, uint value)
+{
+  assert(values_[k] == 0 && value >= 1 && value <= SIZE);
+
+  Mask mask = ValueSet::valueMask(value);
+
+  // record placement (and which used values are new) for undo
+  Change change;
+
+  change.pos    = ushort(k);
+  change.values = solve_values_[k];
+  change.flags  = Change::PLACED;
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  // fail if value already used in row, col or block
+  bool valid = true;
 
-    if (values.values[pc1.k()])
-      cell.setValue(values.values[pc1.k()]);
+  const uint8_t *units = sudokuTables<N>.cell_units[k];
+
+  for (uint n = 0; n < 3; ++n) {
+    Mask &used = unit_used_[units[n]];
+
+    if (used & mask)
+      valid = false;
     else
-      cell.resetValue();
+      change.flags = ushort(change.flags | (Change::ROW_USED << n));
+
+    used = Mask(used | mask);
   }
 
-  valid_ = checkValid();
+  trail_.push_back(change);
+
+  values_      [k] = uint8_t(value);
+  solve_values_[k] = mask;
+
+  // remove value from peer cells (fail if any has no possible values left)
+  const auto *peers = sudokuTables<N>.peers[k];
+
+  for (uint n = 0; n < NUM_PEERS; ++n)
+    if (! removePeerValues(peers[n], mask))
+      valid = false;
+
+  return valid;
+}
+
+template<uint N>
+bool
+CSudokuT<N>::
+removePeerValues(uint k, Mask mask)
+{
+  if (values_[k] != 0)
+    return true;
+
+  removeSolvedValues(k, mask);
+
+  return (solve_values_[k] != 0);
 }
 
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
+removeSolvedValues(uint k, Mask mask)
+{
+  Mask old_values = solve_values_[k];
+
+  if (! (old_values & mask))
+    return false;
+
+  solve_values_[k] = Mask(old_values & ~mask);
+
+  // record previous possible values for undo
+  Change change;
+
+  change.pos    = ushort(k);
+  change.values = old_values;
+  change.flags  = 0;
+
+  trail_.push_back(change);
+
+  return true;
+}
+
+template<uint N>
+void
+CSudokuT<N>::
+rewindState(uint mark)
+{
+  assert(mark <= trail_.size());
+
+  // undo changes in reverse order back to mark
+  while (trail_.size() > mark) {
+    const Change &change = trail_.back();
+
+    uint k = change.pos;
+
+    if (change.flags & Change::PLACED) {
+      Mask mask = ValueSet::valueMask(values_[k]);
+
+      const uint8_t *units = sudokuTables<N>.cell_units[k];
+
+      for (uint n = 0; n < 3; ++n) {
+        if (change.flags & (Change::ROW_USED << n))
+          unit_used_[units[n]] = Mask(unit_used_[units[n]] & ~mask);
+      }
+
+      values_[k] = 0;
+    }
+
+    solve_values_[k] = change.values;
+
+    trail_.pop_back();
+  }
+}
+
+#ifdef CSUDOKU_STATS
+template<uint N>
+CSudokuStats
+CSudokuT<N>::
+getTotalStats() const
+{
+  CSudokuStats stats = total_stats_;
+
+  stats += stats_;
+
+  return stats;
+}
+
+template<uint N>
+void
+CSudokuT<N>::
+resetStats()
+{
+  total_stats_ += stats_;
+
+  stats_.reset();
+}
+#endif
+
+template<uint N>
+bool
+CSudokuT<N>::
 solvable()
 {
   return initSolution();
 }
 
+template<uint N>
+uint
+CSudokuT<N>::
+countSolutions(uint limit)
+{
+  if (! valid_ || limit == 0)
+    return 0;
+
+  if (engine_ != ENGINE_STRATEGY)
+    return engineSolve(NULL, limit);
+
+  // search from current values then undo all placements
+  uint mark  = markState();
+  uint count = 0;
+
+  if (num_threads_ > 1)
+    count = parallelIterCount(limit);
+  else
+    iterCount(limit, count);
+
+  rewindState(mark);
+
+  return count;
+}
+
+template<uint N>
+CSudokuRating
+CSudokuT<N>::
+rate()
+{
+  CSudokuRating rating;
+
+  if (! valid_)
+    return rating;
+
+  // guesses place solution values (search engine is much faster than strategies)
+  Engine engine = (engine_ == ENGINE_DLX ? ENGINE_DLX : ENGINE_BITBOARD);
+
+  uint8_t solution[AREA];
+
+  ulong num_nodes = 0;
+
+  uint num_solutions = solveValues(values_, solution, 1, engine, num_nodes);
+
+  num_nodes_ += num_nodes;
+
+  if (num_solutions == 0)
+    return rating;
+
+  // apply weakest technique which changes board until solved then undo all changes
+  uint mark = markState();
+  bool log  = log_;
+
+  log_ = false;
+
+  // unique values places all found in one pass (each placement is a step)
+  auto numUnknown = [&]() { return uint(std::count(values_, values_ + AREA, 0)); };
+
+  while (! isSolved()) {
+    uint num_unknown = numUnknown();
+
+    if      (addSolvedValues  ()) rating.addStep(CSudokuRating::SINGLE_VALUE);
+    else if (checkUniqueValues()) rating.addStep(CSudokuRating::UNIQUE_VALUE,
+                                                 num_unknown - numUnknown());
+    else if (checkLockedValues()) rating.addStep(CSudokuRating::LOCKED_VALUES);
+    else {
+      CSudokuRating::Technique technique = CSudokuRating::GUESS;
+
+      for (uint size = 2; size <= MAX_SUBSET_SIZE && technique == CSudokuRating::GUESS; ++size) {
+        if      (checkSubsetValues(size, false))
+          technique = CSudokuRating::subsetTechnique(size, false);
+        else if (checkSubsetValues(size, true))
+          technique = CSudokuRating::subsetTechnique(size, true);
+      }
+
+      for (uint size = 2; size <= MAX_FISH_SIZE && technique == CSudokuRating::GUESS; ++size) {
+        if (checkFishValues(size))
+          technique = CSudokuRating::fishTechnique(size);
+      }
+
+      if (technique == CSudokuRating::GUESS) {
+        uint k = minValuesCell();
+
+        if (! placeValue(k, solution[k]))
+          valid_ = false;
+      }
+
+      rating.addStep(technique);
+    }
+
+    if (! valid_)
+      break;
+  }
+
+  rating.solved = valid_;
+
+  rewindState(mark);
+
+  valid_ = true;
+  log_   = log;
+
+  return rating;
+}
+
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
 initSolution()
 {
+  if (engine_ != ENGINE_STRATEGY) {
+    if (engineSolve(solution_values_) > 0)
+      return true;
+
+    memcpy(solution_values_, values_, sizeof(solution_values_));
+
+    return false;
+  }
+
   // save values
-  saveState();
+  uint mark  = markState();
+  bool valid = valid_;
 
   // solve
   bool solved = true;
@@ -312,42 +842,44 @@ initSolution()
   }
 
   // store solved values
-  CellIterator pc1, pc2;
-
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
-
-    uint value = cell.getValue();
-
-    if (value)
-      cell.setSolutionValue(value);
-    else
-      cell.resetSolutionValue();
-  }
+  memcpy(solution_values_, values_, sizeof(solution_values_));
 
   // restore values
-  restoreState();
+  rewindState(mark);
+
+  valid_ = valid;
 
   return solved;
 }
 
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
 solveStep()
 {
   log_ = true;
 
-  bool rc = solve1();
+  bool rc = solve1(false);
 
   log_ = false;
 
   return rc;
 }
 
+template<uint N>
 bool
-CSudoku::
+CSudokuT<N>::
 solve()
 {
+  if (engine_ != ENGINE_STRATEGY) {
+    uint8_t solution[AREA];
+
+    if (engineSolve(solution) > 0)
+      placeSolution(solution);
+
+    return isSolved();
+  }
+
   log_ = true;
 
   while (! isSolved())
@@ -360,896 +892,1167 @@ solve()
   return isSolved();
 }
 
+template<uint N>
 bool
-CSudoku::
-solve1()
+CSudokuT<N>::
+solve1(bool fixpoint)
 {
+  // placements only check the placed value so fail early for invalid grid
+  if (! valid_)
+    return false;
+
   if (isSolved())
     return true;
 
-  while (true) {
-    // remove twin values
-    bool rc1 = checkTwinValues();
+  if (fixpoint) {
+    // apply all strategies until none changes board
+    if (propagate())
+      return valid_;
+  }
+  else {
+    // check single solutions (placement updates unknown cells solutions and validity)
+    if (addSolvedValues())
+      return valid_;
 
-    // remove triple values
-    bool rc2 = checkTripleValues();
+    // check unique values
+    if (checkUniqueValues())
+      return valid_;
 
-    if (! rc1 && ! rc2)
-      break;
+    if (checkEliminations())
+      return valid_;
   }
 
-  // check single solutions
-  if (addSolvedValues()) {
-    // update unknown cells solutions and ensure valid
-    valid_ = checkValid();
+  // no single solution so try all values
+  if (logging())
+    logEvent(CSudokuEvent::search());
 
-    return valid_;
-  }
+  // search starts with cell with fewest possible values
+  uint mark  = markState();
+  uint min_k = minValuesCell();
 
-  // check unique values
-  if (checkUniqueValues()) {
-    // update unknown cells solutions and ensure valid
-    valid_ = checkValid();
+  // strategies applied at search nodes aren't logged (they may be undone)
+  bool logged = log_;
 
-    return valid_;
-  }
+  log_ = false;
 
-  //if (log_) return false;
+  bool solved = (num_threads_ > 1 ? parallelIterSolve() : iterSolve());
 
-  // no single solution so try all values
-  log("Iterate solution");
+  log_ = logged;
+
+  if (solved) {
+    CSUDOKU_STATS_SUCCESS(ITER_SOLVE);
+
+    // single step only keeps value of guessed cell (which led to solution)
+    if (! fixpoint) {
+      uint value = values_[min_k];
+
+      rewindState(mark);
+
+      if (! placeValue(min_k, value))
+        valid_ = false;
+    }
 
-  if (iterSolve())
     return true;
+  }
+
+  rewindState(mark);
 
   return false;
 }
 
+// apply strategies until none changes board (or it is invalid) using the
+// change trail as a work list. Single values are checked for cells changed
+// since they were last checked and unique values for units containing them,
+// so each placement only re-examines its peers. Stronger strategies (which scan
+// the whole board) are only used when no single or unique value is left.
+template<uint N>
 bool
-CSudoku::
-iterSolve()
+CSudokuT<N>::
+propagate()
 {
-  if (isSolved())
+  // place single value of cell (if any)
+  auto placeSingle = [&](uint k) {
+    uint new_value = ValueSet(solve_values_[k]).getUniqueValue();
+
+    if (new_value == 0)
+      return false;
+
+    if (! placeValue(k, new_value))
+      valid_ = false;
+
+    if (logging())
+      logEvent(CSudokuEvent::placement(CSudokuEvent::SINGLE_VALUE, k / SIZE, k % SIZE,
+                                       new_value));
+
     return true;
+  };
 
-  uint min_num = SIZE;
-  uint min_k   = 0;
+  // first pass checks all cells and units
+  bool unit_changed[NUM_UNITS];
 
-  // find cell with least num possible values
-  CellIterator pc1, pc2;
+  std::fill(unit_changed, unit_changed + NUM_UNITS, true);
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  uint pos = markState(); // first trail change not yet checked
 
-    if (cell.isUnknown()) {
-      uint num = cell.getNumSolvedValues();
+  // place single values of changed cells (or all cells). Placements add
+  // changes to trail so they cascade in one pass.
+  auto checkSingles = [&](bool all) {
+    CSUDOKU_STATS_CALL(SOLVED_VALUES);
 
-      if (num < min_num) {
-         min_num = num;
-         min_k   = pc1.k();
-      }
+    uint num_placed = 0;
+
+    if (all) {
+      for (uint k = 0; k < AREA && valid_; ++k)
+        if (values_[k] == 0 && placeSingle(k)) ++num_placed;
     }
-  }
 
-  // Try each value in turn
-  bool solved = false;
+    for ( ; pos < markState() && valid_; ++pos) {
+      uint k = trail_[pos].pos;
 
-  Cell &min_cell = getCell(min_k);
+      const uint8_t *units = sudokuTables<N>.cell_units[k];
 
-  std::vector<uint> solve_values = min_cell.getSolveValues();
+      for (uint n = 0; n < 3; ++n)
+        unit_changed[units[n]] = true;
 
-  auto num_solve_values = solve_values.size();
+      if (values_[k] == 0 && placeSingle(k))
+        ++num_placed;
+    }
 
-  for (uint i = 0; i < num_solve_values; ++i) {
-    uint value = solve_values[i];
+    if (num_placed) {
+      CSUDOKU_STATS_SUCCESS(SOLVED_VALUES);
+      CSUDOKU_STATS_CHANGES(SOLVED_VALUES, num_placed);
+    }
 
-    saveState();
+    return num_placed;
+  };
 
-    min_cell.setValue(value);
+  // place unique values of changed units
+  auto checkUniques = [&]() {
+    CSUDOKU_STATS_CALL(UNIQUE_VALUES);
 
-    bool valid = checkValid();
+    uint num_placed = 0;
 
-    if (valid)
-      solved = iterSolve();
-    else
-      solved = false;
+    for (uint u = 0; u < NUM_UNITS && valid_; ++u) {
+      if (! unit_changed[u]) continue;
+
+      unit_changed[u] = false;
 
-    restoreState();
+      num_placed += checkUniqueUnit(u);
+    }
 
-    if (solved) {
-      min_cell.setValue(value);
+    if (num_placed) {
+      CSUDOKU_STATS_SUCCESS(UNIQUE_VALUES);
+      CSUDOKU_STATS_CHANGES(UNIQUE_VALUES, num_placed);
+    }
 
-      valid_ = checkValid();
+    return num_placed;
+  };
 
+  bool changed = false;
+  bool all     = true;
+
+  while (valid_) {
+    if (checkSingles(all))
+      changed = true;
+
+    all = false;
+
+    if (! valid_)
       break;
+
+    if (checkUniques()) {
+      changed = true;
+
+      continue;
     }
+
+    if (pos < markState())
+      continue;
+
+    // no singles left so try stronger strategies
+    if (isSolved() || ! checkEliminations())
+      break;
+
+    changed = true;
   }
 
-  return solved;
+  return changed;
 }
 
+// remove values using block and row/col intersections, then subsets, then
+// fish (smallest first, stop at first which changes board)
+template<uint N>
 bool
-CSudoku::
-addSolvedValues()
+CSudokuT<N>::
+checkEliminations()
 {
-  // check all unknown cells for single solution
-  CellIterator pc1, pc2;
+  if (checkLockedValues())
+    return true;
+
+  for (uint size = 2; size <= MAX_SUBSET_SIZE; ++size) {
+    if (checkSubsetValues(size, false) || checkSubsetValues(size, true))
+      return true;
+  }
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  for (uint size = 2; size <= MAX_FISH_SIZE; ++size) {
+    if (checkFishValues(size))
+      return true;
+  }
 
-    if (cell.isUnknown()) {
-      uint new_value = cell.getSolvedValue();
+  return false;
+}
 
-      if (new_value != 0) {
-        // update value with solution
-        cell.setValue(new_value);
+template<uint N>
+uint
+CSudokuT<N>::
+engineSolve(uint8_t *solution, uint limit)
+{
+  ulong num_nodes = 0;
 
-        log("Single Value " + intToString(new_value) +
-            " for Cell (" + intToString(pc1.i()) + "," + intToString(pc1.j()) + ") ");
+  uint num_solutions = solveValues(values_, solution, limit, engine_, num_nodes);
 
-        return true;
-      }
-    }
-  }
+  num_nodes_ += num_nodes;
 
-  return false;
+  return num_solutions;
 }
 
-bool
-CSudoku::
-checkSolvedValues()
+template<uint N>
+uint
+CSudokuT<N>::
+solveValues(const uint8_t *values, uint8_t *solution, uint limit, Engine engine,
+            ulong &num_nodes, ulong max_nodes)
 {
-  // check if any unknown cell has single solution
-  CellIterator pc1, pc2;
+  // bitboard kernel is specific to 9x9 grids (9x9 searches are small so it has
+  // no node limit)
+  if (engine == ENGINE_BITBOARD && N == 3)
+    return CSudokuBitBoard::solve(values, solution, limit, &num_nodes);
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  // link matrix is large so share one per thread
+  static thread_local CSudokuDLX dlx(CELL_SIZE);
 
-    if (cell.isUnknown()) {
-      uint new_value = cell.getSolvedValue();
+  uint num_solutions = dlx.solve(values, solution, limit, max_nodes);
 
-      if (new_value != 0)
-        return true;
-    }
-  }
+  num_nodes = dlx.getNumNodes();
 
-  return false;
+  // search stopped at node limit counts as limit solutions
+  if (dlx.isStopped())
+    return std::max(num_solutions, limit);
+
+  return num_solutions;
 }
 
+template<uint N>
 bool
-CSudoku::
-checkUniqueValues()
+CSudokuT<N>::
+iterSolve()
 {
-  // TODO: collect all values for each row, col, cell update cell by associated row/col/cell
+  CSUDOKU_STATS_SEARCH_CALL();
 
-  CellIterator pc1, pc2;
+  // apply strategies before branching (changes are undone by caller's rewind)
+  propagate();
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  if (! valid_) {
+    valid_ = true;
 
-    if (! cell.isUnknown()) continue;
-
-    if (checkUniqueRow (cell, pc1.i(), pc1.j())) return true;
-    if (checkUniqueCol (cell, pc1.i(), pc1.j())) return true;
-    if (checkUniqueCell(cell, pc1.i(), pc1.j())) return true;
+    return false;
   }
 
-  return false;
-}
+  if (isSolved())
+    return true;
 
-bool
-CSudoku::
-checkUniqueRow(Cell &cell, uint i, uint j)
-{
-  ValueSet values = cell.getSolveValueSet();
+  uint min_k = minValuesCell();
+
+  // Try each value in turn
+  bool solved = false;
 
-  RowIterator pr1, pr2;
+  Mask solve_mask = solve_values_[min_k];
 
-  for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-    if (j == pr1.j()) continue;
+  for ( ; solve_mask; solve_mask = ValueSet::removeLowest(solve_mask)) {
+    if (cancel_ && *cancel_)
+      break;
 
-    Cell &cell1 = *pr1;
+    uint value = ValueSet::lowestValue(solve_mask);
 
-    if (! cell1.isUnknown()) continue;
+    uint mark = markState();
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+    ++num_nodes_;
 
-    values.removeValues(values1);
-  }
+    CSUDOKU_STATS_SEARCH(nodes);
 
-  uint new_value = values.getUniqueValue();
+    bool valid = placeValue(min_k, value);
 
-  if (new_value != 0) {
-    cell.setValue(new_value);
+    if (valid)
+      solved = iterSolve();
+    else
+      solved = false;
 
-    log("Unique Value " + intToString(new_value) +
-        " for Cell (" + intToString(i) + "," + intToString(j) + ") ");
+    // keep solved values, otherwise undo changes and try next value
+    if (solved)
+      break;
 
-    return true;
+    rewindState(mark);
+
+    CSUDOKU_STATS_SEARCH(backtracks);
   }
 
-  return false;
+  return solved;
 }
 
-bool
-CSudoku::
-checkUniqueCol(Cell &cell, uint i, uint j)
+template<uint N>
+void
+CSudokuT<N>::
+iterCount(uint limit, uint &count)
 {
-  ValueSet values = cell.getSolveValueSet();
+  // apply strategies before branching (changes are undone by caller's rewind)
+  propagate();
 
-  ColIterator pc1, pc2;
+  if (! valid_) {
+    valid_ = true;
 
-  for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-    if (i == pc1.i()) continue;
+    return;
+  }
 
-    Cell &cell1 = *pc1;
+  if (isSolved()) {
+    ++count;
 
-    if (! cell1.isUnknown()) continue;
+    return;
+  }
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+  uint min_k = minValuesCell();
 
-    values.removeValues(values1);
-  }
+  // count solutions for each value in turn (undoing changes after each)
+  Mask solve_mask = solve_values_[min_k];
 
-  uint new_value = values.getUniqueValue();
+  for ( ; solve_mask; solve_mask = ValueSet::removeLowest(solve_mask)) {
+    if (cancel_ && *cancel_)
+      break;
 
-  if (new_value != 0) {
-    cell.setValue(new_value);
+    uint value = ValueSet::lowestValue(solve_mask);
 
-    log("Unique Value " + intToString(new_value) +
-        " for Cell (" + intToString(i) + "," + intToString(j) + ") ");
+    uint mark = markState();
 
-    return true;
-  }
+    ++num_nodes_;
 
-  return false;
+    if (placeValue(min_k, value))
+      iterCount(limit, count);
+
+    rewindState(mark);
+
+    if (count >= limit)
+      break;
+  }
 }
 
-bool
-CSudoku::
-checkUniqueCell(Cell &cell, uint i, uint j)
+// add values of each board reached by placing values in the least possible
+// values cell to depth (invalid placements are skipped)
+template<uint N>
+void
+CSudokuT<N>::
+splitSearch(uint depth, std::vector<Values> &subproblems)
 {
-  ValueSet values = cell.getSolveValueSet();
+  if (depth == 0 || isSolved()) {
+    Values values;
 
-  BlockIterator pb1, pb2;
+    for (uint k = 0; k < AREA; ++k)
+      values.values[k] = values_[k];
 
-  for (pb1 = beginBlock(i, j), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-    if (pb1.i() == i && pb1.j() == j) continue;
+    subproblems.push_back(values);
 
-    Cell &cell1 = *pb1;
+    return;
+  }
 
-    if (! cell1.isUnknown()) continue;
+  uint min_k = minValuesCell();
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+  Mask solve_mask = solve_values_[min_k];
 
-    values.removeValues(values1);
-  }
+  for ( ; solve_mask; solve_mask = ValueSet::removeLowest(solve_mask)) {
+    uint value = ValueSet::lowestValue(solve_mask);
 
-  uint new_value = values.getUniqueValue();
+    uint mark = markState();
 
-  if (new_value != 0) {
-    cell.setValue(new_value);
+    ++num_nodes_;
 
-    log("Unique Value " + intToString(new_value) +
-        " for Cell (" + intToString(i) + "," + intToString(j) + ") ");
+    if (placeValue(min_k, value))
+      splitSearch(depth - 1, subproblems);
 
-    return true;
+    rewindState(mark);
   }
-
-  return false;
 }
 
-bool
-CSudoku::
-checkTwinValues()
+// board's thread pool, reused by later calls (recreated if thread count changes)
+template<uint N>
+CSudokuThreadPool &
+CSudokuT<N>::
+threadPool()
 {
-  bool changed = false;
+  if (! pool_ || pool_->getNumThreads() != num_threads_)
+    pool_.reset(new CSudokuThreadPool(num_threads_));
 
-  CellIterator pc1, pc2;
+  return *pool_;
+}
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+// split search deep enough to give each thread several subproblems
+template<uint N>
+void
+CSudokuT<N>::
+splitSubproblems(std::vector<Values> &subproblems)
+{
+  enum { MAX_DEPTH        = 4 };
+  enum { TASKS_PER_THREAD = 4 };
 
-    if (! cell.isUnknown()) continue;
+  for (uint depth = 1; depth <= MAX_DEPTH; ++depth) {
+    subproblems.clear();
 
-    if (cell.getNumSolvedValues() != 2) continue;
+    splitSearch(depth, subproblems);
 
-    if (checkTwinRow (cell, pc1.i(), pc1.j())) changed = true;
-    if (checkTwinCol (cell, pc1.i(), pc1.j())) changed = true;
-    if (checkTwinCell(cell, pc1.i(), pc1.j())) changed = true;
+    if (subproblems.size() >= TASKS_PER_THREAD*num_threads_)
+      break;
   }
-
-  return changed;
 }
 
+// search subproblems in parallel keeping the first solution found (later
+// searches are cancelled)
+template<uint N>
 bool
-CSudoku::
-checkTwinRow(Cell &cell, uint i, uint j)
+CSudokuT<N>::
+parallelIterSolve()
 {
-  uint num_twins   = 1;
-  uint num_unknown = 1;
+  if (isSolved())
+    return true;
 
-  int tj = -1;
+  std::vector<Values> subproblems;
 
-  const ValueSet &values = cell.getSolveValueSet();
+  splitSubproblems(subproblems);
 
-  RowIterator pr1, pr2;
+  std::atomic<bool>  found(false);
+  std::atomic<ulong> num_nodes(0);
+  std::mutex         mutex;
+  uint8_t            solution[AREA];
 
-  for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-    if (j == pr1.j()) continue;
+  CSudokuThreadPool &pool = threadPool();
 
-    Cell &cell1 = *pr1;
+  for (const auto &values : subproblems) {
+    pool.submit([&](uint) {
+      if (found) return;
 
-    if (! cell1.isUnknown()) continue;
+      CSudokuT board;
 
-    ++num_unknown;
+      board.cancel_ = &found;
 
-    if (cell1.getNumSolvedValues() != 2) continue;
+      board.init(values);
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+      bool solved = (board.valid_ && board.iterSolve());
 
-    if (values == values1) {
-      ++num_twins; tj = int(pr1.j());
-    }
-  }
+      num_nodes += board.num_nodes_;
 
-  bool changed = false;
+#ifdef CSUDOKU_STATS
+      {
+        std::lock_guard<std::mutex> lock(mutex);
 
-  if (num_twins == 2 && num_unknown > 2) {
-    for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-      if (pr1.j() == j || int(pr1.j()) == tj) continue;
+        stats_ += board.stats_;
+      }
+#endif
 
-      Cell &cell1 = *pr1;
+      if (! solved)
+        return;
 
-      if (! cell1.isUnknown()) continue;
+      std::lock_guard<std::mutex> lock(mutex);
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
-    }
+      if (! found) {
+        memcpy(solution, board.values_, sizeof(solution));
+
+        found = true;
+      }
+    });
   }
 
-  if (changed)
-    log("Twin Value for Row : Cell (" + intToString(i) + "," + intToString(j) + ") ");
+  pool.wait();
 
-  return changed;
-}
+  num_nodes_ += num_nodes;
 
-bool
-CSudoku::
-checkTwinCol(Cell &cell, uint i, uint j)
-{
-  uint num_twins  = 1;
-  uint num_unknown = 1;
+  if (! found)
+    return false;
 
-  int ti = -1;
+  placeSolution(solution);
 
-  const ValueSet &values = cell.getSolveValueSet();
+  return true;
+}
 
-  ColIterator pc1, pc2;
+// count solutions of subproblems in parallel and merge counts (remaining
+// searches are cancelled once limit is reached)
+template<uint N>
+uint
+CSudokuT<N>::
+parallelIterCount(uint limit)
+{
+  if (isSolved())
+    return 1;
 
-  for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-    if (i == pc1.i()) continue;
+  std::vector<Values> subproblems;
 
-    Cell &cell1 = *pc1;
+  splitSubproblems(subproblems);
 
-    if (! cell1.isUnknown()) continue;
+  std::atomic<uint>  total    (0);
+  std::atomic<bool>  done     (false);
+  std::atomic<ulong> num_nodes(0);
 
-    ++num_unknown;
+  CSudokuThreadPool &pool = threadPool();
 
-    if (cell1.getNumSolvedValues() != 2) continue;
+  for (const auto &values : subproblems) {
+    pool.submit([&](uint) {
+      if (done) return;
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+      CSudokuT board;
 
-    if (values == values1) {
-      ++num_twins; ti = int(pc1.i());
-    }
-  }
+      board.cancel_ = &done;
 
-  bool changed = false;
+      board.init(values);
 
-  if (num_twins == 2 && num_unknown > 2) {
-    for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-      if (pc1.i() == i || int(pc1.i()) == ti) continue;
+      uint count = 0;
 
-      Cell &cell1 = *pc1;
+      if (board.valid_)
+        board.iterCount(limit, count);
 
-      if (! cell1.isUnknown()) continue;
+      num_nodes += board.num_nodes_;
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
-    }
+      if (count > 0 && (total += count) >= limit)
+        done = true;
+    });
   }
 
-  if (changed)
-    log("Twin Value for Col : Cell (" + intToString(i) + "," + intToString(j) + ") ");
+  pool.wait();
 
-  return changed;
+  num_nodes_ += num_nodes;
+
+  return std::min(uint(total), limit);
 }
 
-bool
-CSudoku::
-checkTwinCell(Cell &cell, uint i, uint j)
+template<uint N>
+uint
+CSudokuT<N>::
+minValuesCell() const
 {
-  uint num_twins   = 1;
-  uint num_unknown = 1;
+  uint min_num = SIZE + 1;
+  uint min_k   = 0;
 
-  int ti = -1, tj = -1;
+  // find unknown cell with least num possible values
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] == 0) {
+      uint num = ValueSet::countValues(solve_values_[k]);
 
-  const ValueSet &values = cell.getSolveValueSet();
+      if (num < min_num) {
+         min_num = num;
+         min_k   = k;
+      }
+    }
+  }
 
-  BlockIterator pb1, pb2;
+  return min_k;
+}
 
-  for (pb1 = beginBlock(i, j), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-    if (pb1.i() == i && pb1.j() == j) continue;
+// place values of solution in unknown cells
+template<uint N>
+void
+CSudokuT<N>::
+placeSolution(const uint8_t *solution)
+{
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] == 0 && ! placeValue(k, solution[k]))
+      valid_ = false;
+  }
+}
 
-    Cell &cell1 = *pb1;
+template<uint N>
+bool
+CSudokuT<N>::
+addSolvedValues()
+{
+  CSUDOKU_STATS_CALL(SOLVED_VALUES);
 
-    if (! cell1.isUnknown()) continue;
+  // check all unknown cells for single solution
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] == 0) {
+      uint new_value = ValueSet(solve_values_[k]).getUniqueValue();
 
-    ++num_unknown;
+      if (new_value != 0) {
+        // update value with solution
+        if (! placeValue(k, new_value))
+          valid_ = false;
 
-    if (cell1.getNumSolvedValues() != 2) continue;
+        if (logging())
+          logEvent(CSudokuEvent::placement(CSudokuEvent::SINGLE_VALUE, k / SIZE, k % SIZE,
+                                           new_value));
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+        CSUDOKU_STATS_SUCCESS(SOLVED_VALUES);
+        CSUDOKU_STATS_CHANGES(SOLVED_VALUES, 1);
 
-    if (values == values1) {
-      ++num_twins; ti = int(pb1.i()); tj = int(pb1.j());
+        return true;
+      }
     }
   }
 
-  bool changed = false;
-
-  if (num_twins == 2 && num_unknown > 2) {
-    for (pb1 = beginBlock(i, j), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-      if ((    pb1.i()  == i  &&     pb1.j()  == j ) ||
-          (int(pb1.i()) == ti && int(pb1.j()) == tj)) continue;
-
-      Cell &cell1 = *pb1;
+  return false;
+}
 
-      if (! cell1.isUnknown()) continue;
+template<uint N>
+bool
+CSudokuT<N>::
+checkSolvedValues()
+{
+  // check if any unknown cell has single solution
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] == 0) {
+      uint new_value = ValueSet(solve_values_[k]).getUniqueValue();
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
+      if (new_value != 0)
+        return true;
     }
   }
 
-  if (changed)
-    log("Twin Value for Cell : Cell (" + intToString(i) + "," + intToString(j) + ") ");
-
-  return changed;
+  return false;
 }
 
+template<uint N>
 bool
-CSudoku::
-checkTripleValues()
+CSudokuT<N>::
+checkUniqueValues()
 {
-  CellIterator pc1, pc2;
+  CSUDOKU_STATS_CALL(UNIQUE_VALUES);
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  // place values possible in only one cell of each unit (each unit is checked
+  // after placements in previous units)
+  uint num_placed = 0;
 
-    if (! cell.isUnknown()) continue;
+  for (uint u = 0; u < NUM_UNITS; ++u)
+    num_placed += checkUniqueUnit(u);
 
-    if (cell.getNumSolvedValues() != 3) continue;
+  if (num_placed == 0)
+    return false;
 
-    if (checkTripleRow (cell, pc1.i(), pc1.j())) return true;
-    if (checkTripleCol (cell, pc1.i(), pc1.j())) return true;
-    if (checkTripleCell(cell, pc1.i(), pc1.j())) return true;
-  }
+  CSUDOKU_STATS_SUCCESS(UNIQUE_VALUES);
+  CSUDOKU_STATS_CHANGES(UNIQUE_VALUES, num_placed);
 
-  return false;
+  return true;
 }
 
-bool
-CSudoku::
-checkTripleRow(Cell &cell, uint i, uint j)
+template<uint N>
+uint
+CSudokuT<N>::
+checkUniqueUnit(uint u)
 {
-  uint num_triples = 1;
-  uint num_unknown = 1;
+  const auto *unit = sudokuTables<N>.units[u];
 
-  int tj1 = -1, tj2 = -1;
+  // values possible in at least one and in more than one unknown cell
+  Mask once = 0, twice = 0;
 
-  const ValueSet &values = cell.getSolveValueSet();
+  for (uint n = 0; n < SIZE; ++n) {
+    uint k = unit[n];
 
-  RowIterator pr1, pr2;
+    if (values_[k] != 0) continue;
 
-  for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-    if (j == pr1.j()) continue;
+    Mask mask = solve_values_[k];
 
-    Cell &cell1 = *pr1;
+    twice = Mask(twice | (once & mask));
+    once  = Mask(once  | mask);
+  }
 
-    if (! cell1.isUnknown()) continue;
+  Mask unique = Mask(once & ~twice);
 
-    ++num_unknown;
+  if (! unique)
+    return 0;
 
-    uint num = cell1.getNumSolvedValues();
+  uint num_placed = 0;
 
-    if (num != 2 && num != 3) continue;
+  for (uint n = 0; n < SIZE && unique; ++n) {
+    uint k = unit[n];
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+    Mask mask = Mask(solve_values_[k] & unique);
 
-    if ((num == 3 && values == values1) ||
-        (num == 2 && values.contains(values1))) {
-      ++num_triples;
+    if (values_[k] != 0 || ! mask) continue;
 
-      if      (tj1 < 0) tj1 = int(pr1.j());
-      else if (tj2 < 0) tj2 = int(pr1.j());
-    }
-  }
+    unique = Mask(unique & ~mask);
 
-  bool changed = false;
+    // cell can't be only cell for two values
+    if (ValueSet::removeLowest(mask))
+      valid_ = false;
 
-  if (num_triples == 3 && num_unknown > 3) {
-    for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-      if (pr1.j() == j || int(pr1.j()) == tj1 || int(pr1.j()) == tj2) continue;
+    uint new_value = ValueSet::lowestValue(mask);
 
-      Cell &cell1 = *pr1;
+    if (! placeValue(k, new_value))
+      valid_ = false;
 
-      if (! cell1.isUnknown()) continue;
+    if (logging())
+      logEvent(CSudokuEvent::placement(CSudokuEvent::UNIQUE_VALUE, k / SIZE, k % SIZE,
+                                       new_value));
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
-    }
+    ++num_placed;
   }
 
-  if (changed)
-    log("Triple Value for Row : Cell (" + intToString(i) + "," + intToString(j) + ") ");
-
-  return changed;
+  return num_placed;
 }
 
+// remove values using intersections of blocks with rows and cols. If a value
+// of a block is only possible in one row (col) segment it is removed from the
+// rest of the row (pointing), and if a value of a row (col) is only possible
+// in one block segment it is removed from the rest of the block (claiming).
+template<uint N>
 bool
-CSudoku::
-checkTripleCol(Cell &cell, uint i, uint j)
+CSudokuT<N>::
+checkLockedValues()
 {
-  uint num_triples = 1;
-  uint num_unknown = 1;
+  CSUDOKU_STATS_CALL(LOCKED_VALUES);
+
+  // possible values of unknown cells of each row and col segment (row/col
+  // cells in block row/col s). Masks are computed once so may include values
+  // removed by earlier segments (which only loses some removals).
+  Mask row_segs[SIZE][CELL_SIZE] = {};
+  Mask col_segs[SIZE][CELL_SIZE] = {};
+
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] != 0) continue;
+
+    uint i = k / SIZE;
+    uint j = k % SIZE;
 
-  int ti1 = -1, ti2 = -1;
+    Mask &row_seg = row_segs[i][j / CELL_SIZE];
+    Mask &col_seg = col_segs[j][i / CELL_SIZE];
 
-  const ValueSet &values = cell.getSolveValueSet();
+    row_seg = Mask(row_seg | solve_values_[k]);
+    col_seg = Mask(col_seg | solve_values_[k]);
+  }
+
+  bool changed = false;
+
+  // line is row or col, pos is position along line
+  auto checkSegment = [&](Mask (*segs)[CELL_SIZE], bool is_row, uint line, uint s) {
+    auto cellPos = [&](uint line1, uint pos) {
+      return (is_row ? line1*SIZE + pos : pos*SIZE + line1);
+    };
+
+    uint band = (line / CELL_SIZE)*CELL_SIZE;
+
+    Mask block_rest = 0, line_rest = 0;
+
+    for (uint n = 0; n < CELL_SIZE; ++n) {
+      if (band + n != line) block_rest = Mask(block_rest | segs[band + n][s]);
+      if (n        != s   ) line_rest  = Mask(line_rest  | segs[line][n]);
+    }
 
-  ColIterator pc1, pc2;
+    Mask pointing = Mask(segs[line][s] & ~block_rest);
+    Mask claiming = Mask(segs[line][s] & ~line_rest );
 
-  for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-    if (i == pc1.i()) continue;
+    uint seg_k = cellPos(line, s*CELL_SIZE);
 
-    Cell &cell1 = *pc1;
+    CSudokuEvent::UnitType unit_type = (is_row ? CSudokuEvent::ROW : CSudokuEvent::COL);
 
-    if (! cell1.isUnknown()) continue;
+    if (pointing) {
+      bool changed1 = false;
 
-    ++num_unknown;
+      for (uint pos = 0; pos < SIZE; ++pos) {
+        uint k = cellPos(line, pos);
 
-    uint num = cell1.getNumSolvedValues();
+        if (pos / CELL_SIZE == s || values_[k] != 0) continue;
 
-    if (num != 2 && num != 3) continue;
+        if (removeSolvedValues(k, pointing)) {
+          CSUDOKU_STATS_CHANGES(LOCKED_VALUES, 1);
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+          changed1 = true;
+        }
+      }
 
-    if ((num == 3 && values == values1) ||
-        (num == 2 && values.contains(values1))) {
-      ++num_triples;
+      if (changed1 && logging())
+        logEvent(CSudokuEvent::elimination(CSudokuEvent::POINTING_VALUES, unit_type, line,
+                                           seg_k / SIZE, seg_k % SIZE, pointing));
 
-      if      (ti1 < 0) ti1 = int(pc1.i());
-      else if (ti2 < 0) ti2 = int(pc1.i());
+      if (changed1) changed = true;
     }
-  }
 
-  bool changed = false;
+    if (claiming) {
+      bool changed1 = false;
 
-  if (num_triples == 3 && num_unknown > 3) {
-    for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-      if (pc1.i() == i || int(pc1.i()) == ti1 || int(pc1.i()) == ti2) continue;
+      for (uint n = 0; n < CELL_SIZE; ++n) {
+        if (band + n == line) continue;
 
-      Cell &cell1 = *pc1;
+        for (uint pos = s*CELL_SIZE; pos < (s + 1)*CELL_SIZE; ++pos) {
+          uint k = cellPos(band + n, pos);
 
-      if (! cell1.isUnknown()) continue;
+          if (values_[k] != 0) continue;
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
+          if (removeSolvedValues(k, claiming)) {
+            CSUDOKU_STATS_CHANGES(LOCKED_VALUES, 1);
+
+            changed1 = true;
+          }
+        }
+      }
+
+      if (changed1 && logging())
+        logEvent(CSudokuEvent::elimination(CSudokuEvent::CLAIMING_VALUES, unit_type, line,
+                                           seg_k / SIZE, seg_k % SIZE, claiming));
+
+      if (changed1) changed = true;
+    }
+  };
+
+  for (uint line = 0; line < SIZE; ++line) {
+    for (uint s = 0; s < CELL_SIZE; ++s) {
+      checkSegment(row_segs, true , line, s);
+      checkSegment(col_segs, false, line, s);
     }
   }
 
   if (changed)
-   log("Triple Value for Col : Cell (" + intToString(i) + "," + intToString(j) + ") ");
+    CSUDOKU_STATS_SUCCESS(LOCKED_VALUES);
 
   return changed;
 }
 
+// remove values using naked (size cells of unit with only size possible
+// values) or hidden (size values of unit only possible in size cells) subsets
+template<uint N>
 bool
-CSudoku::
-checkTripleCell(Cell &cell, uint i, uint j)
+CSudokuT<N>::
+checkSubsetValues(uint size, bool hidden)
 {
-  uint num_triples = 1;
-  uint num_unknown = 1;
+  CSUDOKU_STATS_CALL(SUBSET_VALUES);
+
+  bool changed = false;
 
-  int ti1 = -1, ti2 = -1, tj1 = -1, tj2 = -1;
+  for (uint u = 0; u < NUM_UNITS; ++u)
+    if (checkSubsetUnit(u, size, hidden)) changed = true;
 
-  const ValueSet &values = cell.getSolveValueSet();
+  if (changed)
+    CSUDOKU_STATS_SUCCESS(SUBSET_VALUES);
 
-  BlockIterator pb1, pb2;
+  return changed;
+}
 
-  for (pb1 = beginBlock(i, j), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-    if (pb1.i() == i && pb1.j() == j) continue;
+// Naked and hidden subsets are the same search with cells and values swapped.
+// Items are the unit's unknown cells with masks of their possible values
+// (naked) or the unit's unplaced values with masks of the unit positions where
+// they are possible (hidden). A subset of size items whose combined mask has
+// size bits removes those bits from all other items.
+template<uint N>
+bool
+CSudokuT<N>::
+checkSubsetUnit(uint u, uint size, bool hidden)
+{
+  assert(size >= 2 && size <= MAX_SUBSET_SIZE);
 
-    Cell &cell1 = *pb1;
+  const auto *unit = sudokuTables<N>.units[u];
 
-    if (! cell1.isUnknown()) continue;
+  uint items[SIZE]; // unit position (naked) or value (hidden) of each item
+  Mask masks[SIZE];
 
-    ++num_unknown;
+  bool changed = false;
 
-    uint num = cell1.getNumSolvedValues();
+  while (true) {
+    uint num_items = 0;
 
-    if (num != 2 && num != 3) continue;
+    if (! hidden) {
+      for (uint n = 0; n < SIZE; ++n) {
+        uint k = unit[n];
 
-    const ValueSet &values1 = cell1.getSolveValueSet();
+        if (values_[k] != 0) continue;
 
-    if ((num == 3 && values == values1) ||
-        (num == 2 && values.contains(values1))) {
-      ++num_triples;
+        items[num_items] = n;
+        masks[num_items] = solve_values_[k];
 
-      if      (ti1 < 0) { ti1 = int(pb1.i()); tj1 = int(pb1.j()); }
-      else if (ti2 < 0) { ti2 = int(pb1.i()); tj2 = int(pb1.j()); }
+        ++num_items;
+      }
     }
-  }
+    else {
+      Mask positions[SIZE] = {};
 
-  bool changed = false;
+      for (uint n = 0; n < SIZE; ++n) {
+        uint k = unit[n];
 
-  if (num_triples == 3 && num_unknown > 3) {
-    for (pb1 = beginBlock(i, j), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-      if ((    pb1.i()  == i   &&     pb1.j()  == j  ) ||
-          (int(pb1.i()) == ti1 && int(pb1.j()) == tj1) ||
-          (int(pb1.i()) == ti2 && int(pb1.j()) == tj2)) continue;
+        if (values_[k] != 0) continue;
 
-      Cell &cell1 = *pb1;
+        for (Mask m = solve_values_[k]; m; m = ValueSet::removeLowest(m)) {
+          Mask &position = positions[ValueSet::lowestValue(m) - 1];
 
-      if (! cell1.isUnknown()) continue;
+          position = Mask(position | (1U << n));
+        }
+      }
 
-      if (cell1.removeSolvedValues(values))
-        changed = true;
+      for (uint v = 0; v < SIZE; ++v) {
+        if (! positions[v]) continue;
+
+        items[num_items] = v + 1;
+        masks[num_items] = positions[v];
+
+        ++num_items;
+      }
     }
-  }
 
-  if (changed)
-    log("Triple Value for Cell : Cell (" + intToString(i) + "," + intToString(j) + ") ");
+    // subset needs other items to remove values from
+    if (num_items <= size)
+      break;
 
-  return changed;
-}
+    uint subset      = 0;
+    Mask subset_mask = 0;
 
-bool
-CSudoku::
-checkValid()
-{
-  // reset unknown cells set of possible solutions
-  initSolveValues();
+    if (! findSubset(masks, num_items, size, 0, subset, subset_mask))
+      break;
 
-  bool flag = true;
+    // remove subset's values from other cells (naked) or other values from
+    // subset's cells (hidden)
+    Mask values   = 0;
+    uint subset_k = 0;
 
-  // remove all values already used in cells, rows and cols
-  // (fail if grid is invalid - no solution possible)
-  for (uint i = 0; i < SIZE; ++i)
-    if (! solveCell(i))
-      flag = false;
+    if (! hidden) {
+      values   = subset_mask;
+      subset_k = unit[items[__builtin_ctz(subset)]];
 
-  for (uint i = 0; i < SIZE; ++i)
-    if (! solveRow(i))
-      flag = false;
+      for (uint i = 0; i < num_items; ++i) {
+        if (subset & (1U << i)) continue;
 
-  for (uint i = 0; i < SIZE; ++i)
-    if (! solveCol(i))
-      flag = false;
+        if (removeSolvedValues(unit[items[i]], subset_mask))
+          CSUDOKU_STATS_CHANGES(SUBSET_VALUES, 1);
+      }
+    }
+    else {
+      for (uint i = 0; i < num_items; ++i)
+        if (subset & (1U << i))
+          values = Mask(values | ValueSet::valueMask(items[i]));
 
-  return flag;
-}
+      subset_k = unit[__builtin_ctz(subset_mask)];
 
-void
-CSudoku::
-initSolveValues()
-{
-  CellIterator pc1, pc2;
+      Mask other_values = Mask(ValueSet::ALL_MASK & ~values);
+
+      for (Mask m = subset_mask; m; m = ValueSet::removeLowest(m)) {
+        if (removeSolvedValues(unit[ValueSet::lowestValue(m) - 1], other_values))
+          CSUDOKU_STATS_CHANGES(SUBSET_VALUES, 1);
+      }
+    }
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+    if (logging())
+      logEvent(CSudokuEvent::elimination(CSudokuEvent::subsetStrategy(size, hidden), unitType(u),
+                                         u % SIZE, subset_k / SIZE, subset_k % SIZE, values));
 
-    cell.initSolveValue();
+    changed = true;
   }
+
+  return changed;
 }
 
+// remove values using fish. For each value the cols where it is possible in
+// each row (and rows where it is possible in each col) are kept as masks. If
+// the value is only possible in size cols of size rows (a subset of the row
+// masks) it must be in those cols of those rows so is removed from the other
+// rows of the cols (and the same with rows and cols swapped).
+template<uint N>
 bool
-CSudoku::
-solveCell(uint k)
+CSudokuT<N>::
+checkFishValues(uint size)
 {
-  ValueSet values;
+  CSUDOKU_STATS_CALL(FISH_VALUES);
 
-  // get all used values for 3x3 grid
-  BlockIterator pb1, pb2;
+  assert(size >= 2 && size <= MAX_FISH_SIZE);
 
-  for (pb1 = beginBlock(k), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-    Cell &cell = *pb1;
+  // per value masks of possible cols of each row and rows of each col
+  Mask row_planes[SIZE][SIZE] = {};
+  Mask col_planes[SIZE][SIZE] = {};
 
-    if (cell.isUnknown()) continue;
+  for (uint k = 0; k < AREA; ++k) {
+    if (values_[k] != 0) continue;
 
-    uint value = cell.getValue();
+    uint i = k / SIZE;
+    uint j = k % SIZE;
 
-    if (! values.get(value))
-      return false;
+    for (Mask m = solve_values_[k]; m; m = ValueSet::removeLowest(m)) {
+      uint v = ValueSet::lowestValue(m) - 1;
 
-    values.clear(value);
+      row_planes[v][i] = Mask(row_planes[v][i] | (1U << j));
+      col_planes[v][j] = Mask(col_planes[v][j] | (1U << i));
+    }
   }
 
-  // remove used values from grid cells
-  for (pb1 = beginBlock(k), pb2 = endBlock(); pb1 != pb2; ++pb1) {
-    Cell &cell = *pb1;
+  bool changed = false;
 
-    if (! cell.isUnknown()) continue;
+  for (uint v = 0; v < SIZE; ++v) {
+    Mask value_mask = ValueSet::valueMask(v + 1);
 
-    for (uint k1 = 1; k1 <= SIZE; ++k1) {
-      if (! values.get(k1))
-        cell.clearSolveValue(k1);
-    }
-  }
+    for (uint n = 0; n < 2; ++n) {
+      bool is_row = (n == 0);
 
-  return true;
-}
+      Mask *base_planes  = (is_row ? row_planes[v] : col_planes[v]);
+      Mask *cover_planes = (is_row ? col_planes[v] : row_planes[v]);
 
-bool
-CSudoku::
-solveRow(uint i)
-{
-  ValueSet values;
+      uint subset      = 0;
+      Mask subset_mask = 0;
 
-  // get all used values for row
-  RowIterator pr1, pr2;
+      while (findSubset(base_planes, SIZE, size, 0, subset, subset_mask)) {
+        // remove value from cover lines outside base lines
+        for (Mask m = subset_mask; m; m = ValueSet::removeLowest(m)) {
+          uint cover = ValueSet::lowestValue(m) - 1;
 
-  for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-    Cell &cell = *pr1;
+          for (uint base = 0; base < SIZE; ++base) {
+            if ((subset & (1U << base)) || ! (base_planes[base] & (1U << cover))) continue;
 
-    if (cell.isUnknown()) continue;
+            uint k = (is_row ? base*SIZE + cover : cover*SIZE + base);
 
-    uint value = cell.getValue();
+            if (removeSolvedValues(k, value_mask))
+              CSUDOKU_STATS_CHANGES(FISH_VALUES, 1);
 
-    if (! values.get(value))
-      return false;
+            base_planes [base ] = Mask(base_planes [base ] & ~(1U << cover));
+            cover_planes[cover] = Mask(cover_planes[cover] & ~(1U << base ));
+          }
+        }
 
-    values.clear(value);
-  }
+        if (logging()) {
+          uint base  = uint(__builtin_ctz(subset));
+          uint cover = uint(__builtin_ctz(base_planes[base]));
+          uint k     = (is_row ? base*SIZE + cover : cover*SIZE + base);
 
-  // remove used values from row cells
-  for (pr1 = beginRow(i), pr2 = endRow(); pr1 != pr2; ++pr1) {
-    Cell &cell = *pr1;
+          logEvent(CSudokuEvent::elimination(CSudokuEvent::fishStrategy(size),
+                                             is_row ? CSudokuEvent::ROW : CSudokuEvent::COL,
+                                             base, k / SIZE, k % SIZE, value_mask));
+        }
 
-    if (! cell.isUnknown()) continue;
+        changed = true;
 
-    for (uint k = 1; k <= SIZE; ++k) {
-      if (! values.get(k))
-        cell.clearSolveValue(k);
+        subset      = 0;
+        subset_mask = 0;
+      }
     }
   }
 
-  return true;
+  if (changed)
+    CSUDOKU_STATS_SUCCESS(FISH_VALUES);
+
+  return changed;
 }
 
+// find size items (from start) whose combined mask has size bits and overlaps
+// the mask of another item. Items with a single bit are left to the singles
+// strategies.
+template<uint N>
 bool
-CSudoku::
-solveCol(uint j)
+CSudokuT<N>::
+findSubset(const Mask *masks, uint num_items, uint size, uint start, uint &subset,
+           Mask &subset_mask)
 {
-  // get all used values for col
-  ValueSet values;
+  uint depth = uint(__builtin_popcount(subset));
 
-  ColIterator pc1, pc2;
+  if (depth == size) {
+    for (uint i = 0; i < num_items; ++i)
+      if (! (subset & (1U << i)) && (masks[i] & subset_mask))
+        return true;
 
-  for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+    return false;
+  }
 
-    if (cell.isUnknown()) continue;
+  for (uint i = start; i + (size - depth) <= num_items; ++i) {
+    uint num = ValueSet::countValues(masks[i]);
 
-    uint value = cell.getValue();
+    if (num < 2 || num > size) continue;
 
-    if (! values.get(value))
-      return false;
+    Mask mask = Mask(subset_mask | masks[i]);
 
-    values.clear(value);
-  }
+    // combined mask must stay within size bits
+    if (ValueSet::countValues(mask) > size) continue;
 
-  // remove used values from col cells
-  for (pc1 = beginCol(j), pc2 = endCol(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+    uint subset1 = subset | (1U << i);
 
-    if (! cell.isUnknown()) continue;
+    if (findSubset(masks, num_items, size, i + 1, subset1, mask)) {
+      subset      = subset1;
+      subset_mask = mask;
 
-    for (uint k = 1; k <= SIZE; ++k) {
-      if (! values.get(k))
-        cell.clearSolveValue(k);
+      return true;
     }
   }
 
-  return true;
+  return false;
 }
 
+template<uint N>
 bool
-CSudoku::
-isSolved()
+CSudokuT<N>::
+checkValid()
 {
-  CellIterator pc1, pc2;
-
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  CSUDOKU_STATS_CALL(CHECK_VALID);
 
-    if (cell.isUnknown())
-      return false;
-  }
+  // reset unknown cells set of possible solutions (previous changes can no longer be undone)
+  initSolveValues();
 
-  return true;
-}
+  trail_.clear();
 
-void
-CSudoku::
-saveState()
-{
-  Values state;
+  bool flag = true;
 
-  CellIterator pc1, pc2;
+  // remove all values already used in rows, cols and cells
+  // (fail if grid is invalid - no solution possible)
+  for (uint u = 0; u < NUM_UNITS; ++u)
+    if (! solveUnit(u))
+      flag = false;
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+  // fail if any unknown cell has no possible values left
+  for (uint k = 0; k < AREA; ++k)
+    if (values_[k] == 0 && solve_values_[k] == 0)
+      flag = false;
 
-    state.values[pc1.k()] = cell.getValue();
-  }
+  if (flag)
+    CSUDOKU_STATS_SUCCESS(CHECK_VALID);
 
-  saved_state_.push_back(state);
+  return flag;
 }
 
+template<uint N>
 void
-CSudoku::
-restoreState()
+CSudokuT<N>::
+initSolveValues()
+{
+  for (uint k = 0; k < AREA; ++k)
+    solve_values_[k] = (values_[k] ? ValueSet::valueMask(values_[k]) : Mask(ValueSet::ALL_MASK));
+}
+
+template<uint N>
+bool
+CSudokuT<N>::
+solveUnit(uint u)
 {
-  assert(! saved_state_.empty());
+  ValueSet used(0);
 
-  Values state = saved_state_.back();
+  bool valid = true;
 
-  saved_state_.pop_back();
+  const auto *unit = sudokuTables<N>.units[u];
 
-  CellIterator pc1, pc2;
+  // get all used values for unit
+  for (uint n = 0; n < SIZE; ++n) {
+    uint value = values_[unit[n]];
 
-  for (pc1 = beginCells(), pc2 = endCells(); pc1 != pc2; ++pc1) {
-    Cell &cell = *pc1;
+    if (value == 0) continue;
 
-    if (state.values[pc1.k()])
-      cell.setValue(state.values[pc1.k()]);
-    else
-      cell.resetValue();
-  }
+    if (used.get(value))
+      valid = false;
 
-  valid_ = checkValid();
-}
+    used.set(value);
+  }
 
-void
-CSudoku::
-log(const std::string &str) const
-{
-  if (log_)
-    std::cerr << str << std::endl;
-}
+  // remove used values from unit cells
+  for (uint n = 0; n < SIZE; ++n) {
+    uint k = unit[n];
 
-std::string
-CSudoku::
-intToString(int i)
-{
-  std::stringstream ss;
+    if (values_[k] == 0)
+      solve_values_[k] = Mask(solve_values_[k] & ~used.getMask());
+  }
 
-  ss << i;
+  unit_used_[u] = used.getMask();
 
-  return ss.str();
+  return valid;
 }
 
-std::string
-CSudoku::
-intToString(uint i)
+template<uint N>
+bool
+CSudokuT<N>::
+isSolved()
 {
-  std::stringstream ss;
+  return (memchr(values_, 0, sizeof(values_)) == NULL);
+}
 
-  ss << i;
+//------
 
-  return ss.str();
-}
+template class CSudokuT<3>;
+template class CSudokuT<4>;
+template class CSudokuT<5>;
@@ -1,218 +1,179 @@
 #ifndef CSUDOKU_H
 #define CSUDOKU_H
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 #include <set>
 
+#include <type_traits>
+
 #include <cassert>
+#include <cstdint>
 #include <sys/types.h>
 
-class CSudoku {
+#include <CSudokuEvents.h>
+#include <CSudokuRating.h>
+#include <CSudokuStats.h>
+
+class CSudokuPackReader;
+class CSudokuPackWriter;
+class CSudokuThreadPool;
+
+// sudoku board with blocks of N x N cells (N*N values per row, col and block).
+// Sizes are compile time constants so loops and masks are fixed for each size.
+template<uint N>
+class CSudokuT {
  public:
-  enum { SIZE = 9         };
-  enum { CELL_SIZE = 3    };
+  enum { SIZE = N*N       };
+  enum { CELL_SIZE = N    };
   enum { AREA = SIZE*SIZE };
 
+  enum { NUM_UNITS = 3*SIZE };
+  enum { NUM_PEERS = 2*(SIZE - 1) + (CELL_SIZE - 1)*(CELL_SIZE - 1) };
+
+  enum { MAX_SUBSET_SIZE = 4 }; // largest naked/hidden subset checked
+  enum { MAX_FISH_SIZE   = 4 }; // largest fish (X-Wing, Swordfish, Jellyfish) checked
+
+  // engine used to calculate solution
+  enum Engine {
+    ENGINE_STRATEGY, // solve strategies with backtracking (iterSolve) fallback
+    ENGINE_DLX,      // dancing links exact cover search
+    ENGINE_BITBOARD  // SIMD bitboard singles propagation and search
+  };
+
  private:
-  // class representing the set of possible for a cell (1-9)
+  static_assert(N >= 2 && N <= 5, "unsupported block size");
+
+  // class representing the set of possible for a cell (1-SIZE)
+  // (stored as a bit mask with bit (i - 1) set if value i is possible)
   class ValueSet {
    public:
+    typedef typename std::conditional<(SIZE <= 16), ushort, uint>::type Mask;
+
+    enum { ALL_MASK = (1 << SIZE) - 1 };
+
     ValueSet() { reset(); }
 
-    void set  (uint i) { values_[i] = true; }
-    void clear(uint i) { values_[i] = false; }
+    explicit ValueSet(Mask mask) : mask_(mask) { }
 
-    bool get(uint i) const { return values_[i]; }
+    static Mask valueMask(uint i) { return Mask(1 << (i - 1)); }
 
-    void reset() {
-      values_[0] = false;
+    void set  (uint i) { mask_ = Mask(mask_ |  valueMask(i)); }
+    void clear(uint i) { mask_ = Mask(mask_ & ~valueMask(i)); }
 
-      for (uint i = 1; i <= SIZE; ++i)
-        values_[i] = true;
-    }
+    bool get(uint i) const { return (mask_ & valueMask(i)); }
 
-    uint getNumValues() const {
-      uint count = 0;
+    Mask getMask() const { return mask_; }
 
-      for (uint i = 1; i <= SIZE; ++i)
-        if (values_[i])
-          ++count;
+    void setMask(Mask mask) { mask_ = mask; }
 
-      return count;
-    }
+    void reset() { mask_ = ALL_MASK; }
+
+    void setOnly(uint i) { mask_ = valueMask(i); }
+
+    bool isEmpty() const { return (mask_ == 0); }
+
+    uint getNumValues() const { return countValues(mask_); }
 
     std::vector<uint> getValues() const {
       std::vector<uint> v;
 
-      for (uint i = 1; i <= SIZE; ++i)
-        if (values_[i])
-          v.push_back(i);
+      for (Mask m = mask_; m; m = removeLowest(m))
+        v.push_back(lowestValue(m));
 
       return v;
     }
 
     uint getUniqueValue() const {
-      uint value = 0;
-
-      for (uint i = 1; i <= SIZE; ++i) {
-        if (! values_[i]) continue;
+      if (! mask_ || removeLowest(mask_))
+        return 0;
 
-        if (value != 0)
-          return 0;
-
-        value = i;
-      }
-
-      return value;
+      return lowestValue(mask_);
     }
 
     bool removeValues(const ValueSet &values) {
-      bool changed = false;
-
-      for (uint i = 1; i <= SIZE; ++i) {
-        if (! values.values_[i] || ! values_[i]) continue;
+      Mask mask = Mask(mask_ & ~values.mask_);
 
-        values_[i] = false;
+      if (mask == mask_)
+        return false;
 
-        changed = true;
-      }
+      mask_ = mask;
 
-      return changed;
+      return true;
     }
 
+    // check if all values in specified set are also in this set
     bool contains(const ValueSet &values) const {
-      for (uint i = 1; i <= SIZE; ++i)
-        if (! values.values_[i] && values.values_[i] != values_[i])
-          return false;
-
-      return true;
+      return ! (values.mask_ & ~mask_);
     }
 
     friend bool operator==(const ValueSet &values1, const ValueSet &values2) {
-      for (uint i = 1; i <= SIZE; ++i)
-        if (values1.values_[i] != values2.values_[i])
-          return false;
-
-      return true;
+      return (values1.mask_ == values2.mask_);
     }
 
+    //---
+
+    static uint countValues(Mask mask) { return uint(__builtin_popcount(mask)); }
+
+    static uint lowestValue(Mask mask) { return uint(__builtin_ctz(mask)) + 1; }
+
+    static Mask removeLowest(Mask mask) { return Mask(mask & (mask - 1)); }
+
    private:
-    bool values_[SIZE + 1]; // indexed by number
+    Mask mask_ { 0 };
   };
 
+  typedef typename ValueSet::Mask Mask;
+
   //------
 
-  // class representing a single cell on the board
+  // class referencing a single cell on the board (cell data is stored in flat
+  // per-board arrays so this only holds the board and cell index)
   class Cell {
    public:
-    Cell() :
-     i_(0), j_(0), init_value_(0), solution_value_(0) {
-      resetValue();
+    Cell(const CSudokuT *sudoku=NULL, uint k=0) :
+     sudoku_(sudoku), k_(k) {
     }
 
-    void setPos(uint i, uint j) { i_ = i; j_ = j; }
-
-    uint getValue() const { return value_; }
-
-    bool isUnknown() const { return (value_ == 0); }
-
-    void setValue(uint value) {
-      assert(value >= 1 && value <= SIZE);
-
-      value_ = value;
-
-      for (uint i = 1; i <= SIZE; ++i)
-        clearSolveValue(i);
-
-      setSolveValue(value_);
-    }
+    uint i() const { return k_ / SIZE; }
+    uint j() const { return k_ % SIZE; }
+    uint k() const { return k_; }
 
-    void resetValue() {
-      value_ = 0;
+    uint getValue() const { return sudoku_->values_[k_]; }
 
-      resetSolvedValues();
-    }
+    bool isUnknown() const { return (getValue() == 0); }
 
     //------
 
-    uint getInitValue() const { return init_value_; }
-
-    void setInitValue(uint value) {
-      assert(value >= 1 && value <= SIZE);
-
-      init_value_ = value;
-    }
-
-    void resetInitValue() {
-      init_value_ = 0;
-    }
+    uint getInitValue() const { return sudoku_->init_values_[k_]; }
 
-    bool isInitUnknown() const { return (init_value_ == 0); }
+    bool isInitUnknown() const { return (getInitValue() == 0); }
 
     //------
 
-    void setSolveValue(uint value) {
-      assert(value >= 1 && value <= SIZE);
-
-      values_.set(value);
-    }
-
-    void clearSolveValue(uint value) {
-      assert(value >= 1 && value <= SIZE);
-
-      values_.clear(value);
-    }
-
     bool isSolveValue(uint value) const {
       assert(value >= 1 && value <= SIZE);
 
-      return values_.get(value);
-    }
-
-    void resetSolvedValues() { values_.reset(); }
-
-    uint getSolvedValue() const { return values_.getUniqueValue(); }
-
-    void initSolveValue() {
-      if (! isUnknown()) {
-        for (uint i = 1; i <= SIZE; ++i)
-          clearSolveValue(i);
-
-        setSolveValue(value_);
-      }
-      else
-        resetSolvedValues();
+      return getSolveValueSet().get(value);
     }
 
-    std::vector<uint> getSolveValues() const { return values_.getValues(); }
+    uint getSolvedValue() const { return getSolveValueSet().getUniqueValue(); }
 
-    const ValueSet &getSolveValueSet() const { return values_; }
+    std::vector<uint> getSolveValues() const { return getSolveValueSet().getValues(); }
 
-    uint getNumSolvedValues() const { return values_.getNumValues(); }
+    ValueSet getSolveValueSet() const { return ValueSet(sudoku_->solve_values_[k_]); }
 
-    bool removeSolvedValues(const ValueSet &values) { return values_.removeValues(values); }
+    uint getNumSolvedValues() const { return getSolveValueSet().getNumValues(); }
 
     //------
 
-    uint getSolutionValue() const { return solution_value_; }
-
-    void setSolutionValue(uint value) {
-      assert(value >= 1 && value <= SIZE);
-
-      solution_value_ = value;
-    }
-
-    void resetSolutionValue() {
-      solution_value_ = 0;
-    }
+    uint getSolutionValue() const { return sudoku_->solution_values_[k_]; }
 
    private:
-    uint     i_, j_;
-    uint     value_;
-    uint     init_value_;
-    uint     solution_value_;
-    ValueSet values_;
+    const CSudokuT *sudoku_;
+    uint           k_;
   };
 
  public:
@@ -220,10 +181,26 @@ class CSudoku {
     uint values[AREA];
   };
 
+ private:
+  // change made to a cell (previous possible values and, if a value was placed,
+  // which row/col/block used values it added) recorded so it can be undone
+  struct Change {
+    enum {
+      PLACED     = (1<<0),
+      ROW_USED   = (1<<1), // used value flags in cell unit order
+      COL_USED   = (1<<2),
+      BLOCK_USED = (1<<3)
+    };
+
+    ushort pos;
+    Mask   values;
+    ushort flags;
+  };
+
  public:
   class CellIterator {
    public:
-    CellIterator(CSudoku *sudoku=NULL) :
+    CellIterator(CSudokuT *sudoku=NULL) :
      sudoku_(sudoku), i_(0), j_(0), k_(0), end_(sudoku_==NULL) {
     }
 
@@ -243,13 +220,7 @@ class CSudoku {
       return *this;
     }
 
-    Cell &operator*() {
-      assert(! end_);
-
-      return sudoku_->getCell(i_, j_);
-    }
-
-    const Cell &operator*() const {
+    Cell operator*() const {
       assert(! end_);
 
       return sudoku_->getCell(i_, j_);
@@ -272,14 +243,14 @@ class CSudoku {
     uint k() const { return k_; }
 
    private:
-    CSudoku *sudoku_;
+    CSudokuT *sudoku_;
     uint     i_, j_, k_;
     bool     end_;
   };
 
   class RowIterator {
    public:
-    RowIterator(CSudoku *sudoku=NULL, uint i=0) :
+    RowIterator(CSudokuT *sudoku=NULL, uint i=0) :
      sudoku_(sudoku), i_(i), j_(0), end_(sudoku_==NULL) {
     }
 
@@ -292,13 +263,7 @@ class CSudoku {
       return *this;
     }
 
-    Cell &operator*() {
-      assert(! end_);
-
-      return sudoku_->getCell(i_, j_);
-    }
-
-    const Cell &operator*() const {
+    Cell operator*() const {
       assert(! end_);
 
       return sudoku_->getCell(i_, j_);
@@ -319,14 +284,14 @@ class CSudoku {
     uint j() const { return j_; }
 
    private:
-    CSudoku *sudoku_;
+    CSudokuT *sudoku_;
     uint     i_, j_;
     bool     end_;
   };
 
   class ColIterator {
    public:
-    ColIterator(CSudoku *sudoku=NULL, uint j=0) :
+    ColIterator(CSudokuT *sudoku=NULL, uint j=0) :
      sudoku_(sudoku), i_(0), j_(j), end_(sudoku_==NULL) {
     }
 
@@ -339,13 +304,7 @@ class CSudoku {
       return *this;
     }
 
-    Cell &operator*() {
-      assert(! end_);
-
-      return sudoku_->getCell(i_, j_);
-    }
-
-    const Cell &operator*() const {
+    Cell operator*() const {
       assert(! end_);
 
       return sudoku_->getCell(i_, j_);
@@ -366,14 +325,14 @@ class CSudoku {
     uint i() const { return i_; }
 
    private:
-    CSudoku *sudoku_;
+    CSudokuT *sudoku_;
     uint     i_, j_;
     bool     end_;
   };
 
   class BlockIterator {
    public:
-    BlockIterator(CSudoku *sudoku=NULL, uint k=0) :
+    BlockIterator(CSudokuT *sudoku=NULL, uint k=0) :
      sudoku_(sudoku), end_(sudoku_==NULL) {
       i1_ = CELL_SIZE*(k % CELL_SIZE);
       i2_ = i1_ + CELL_SIZE - 1;
@@ -384,7 +343,7 @@ class CSudoku {
       j_ = j1_;
     }
 
-    BlockIterator(CSudoku *sudoku, uint i, uint j) :
+    BlockIterator(CSudokuT *sudoku, uint i, uint j) :
      sudoku_(sudoku), end_(sudoku_==NULL) {
       i1_ = CELL_SIZE*(i / CELL_SIZE);
       i2_ = i1_ + CELL_SIZE - 1;
@@ -410,13 +369,7 @@ class CSudoku {
       return *this;
     }
 
-    Cell &operator*() {
-      assert(! end_);
-
-      return sudoku_->getCell(i_, j_);
-    }
-
-    const Cell &operator*() const {
+    Cell operator*() const {
       assert(! end_);
 
       return sudoku_->getCell(i_, j_);
@@ -438,25 +391,21 @@ class CSudoku {
     uint j() const { return j_; }
 
    private:
-    CSudoku *sudoku_;
+    CSudokuT *sudoku_;
     uint     i_, j_;
     uint     i1_, i2_, j1_, j2_;
     bool     end_;
   };
 
  public:
-  CSudoku();
- ~CSudoku() { }
+  CSudokuT();
+ ~CSudokuT();
 
   //-------
 
-  const Cell &getCell(uint i) const { return getCell(i / SIZE, i % SIZE); }
-
-  Cell &getCell(uint i) { return getCell(i / SIZE, i % SIZE); }
+  Cell getCell(uint i) const { return Cell(this, i); }
 
-  const Cell &getCell(uint x, uint y) const { return cells_[x][y]; }
-
-  Cell &getCell(uint x, uint y) { return cells_[x][y]; }
+  Cell getCell(uint x, uint y) const { return Cell(this, x*SIZE + y); }
 
   CellIterator beginCells() { return CellIterator(this); }
   CellIterator endCells  () { return CellIterator(NULL); }
@@ -486,8 +435,49 @@ class CSudoku {
 
   bool getValid() const { return valid_; }
 
+  Engine getEngine() const { return engine_; }
+  void setEngine(Engine engine) { engine_ = engine; }
+
+  // threads used by strategy engine backtracking and solution counting
+  // (top levels of the search are split into subproblems solved in parallel)
+  uint getNumThreads() const { return num_threads_; }
+  void setNumThreads(uint num_threads) { num_threads_ = num_threads; }
+
+  // clues left by newGame (clues are removed, keeping the solution unique,
+  // until this many are left or, if 0, until every clue is needed). A removal
+  // whose uniqueness check needs too many search nodes (about a million, 16K
+  // for 25x25) is kept, so large puzzles may not be quite minimal.
+  uint getGameClues() const { return game_clues_; }
+  void setGameClues(uint n) { game_clues_ = n; }
+
   bool solvable();
 
+  // number of search nodes (values tried by backtracking or engine search)
+  // since board was created
+  ulong getNumNodes() const { return num_nodes_; }
+
+  // receiver of deductions made by solve() and solveStep() (none if NULL)
+  CSudokuEventSink *getEventSink() const { return sink_; }
+  void setEventSink(CSudokuEventSink *sink) { sink_ = sink; }
+
+#ifdef CSUDOKU_STATS
+  // strategy statistics of current game (since it was loaded or generated,
+  // or since resetStats) and of all games played on this board
+  const CSudokuStats &getStats() const { return stats_; }
+
+  CSudokuStats getTotalStats() const;
+
+  void resetStats();
+#endif
+
+  // count solutions up to limit (limit 2 checks for a unique solution).
+  // Board is left unchanged.
+  uint countSolutions(uint limit=2);
+
+  // rate difficulty of solving current values (see CSudokuRating).
+  // Board is left unchanged.
+  CSudokuRating rate();
+
  public:
   bool solve();
   bool solveStep();
@@ -496,56 +486,126 @@ class CSudoku {
   bool checkSolvedValues();
 
   bool checkUniqueValues();
-  bool checkUniqueRow(Cell &cell, uint i, uint j);
-  bool checkUniqueCol(Cell &cell, uint i, uint j);
-  bool checkUniqueCell(Cell &cell, uint i, uint j);
+  uint checkUniqueUnit(uint u);
 
-  bool checkTwinValues();
-  bool checkTwinRow(Cell &cell, uint i, uint j);
-  bool checkTwinCol(Cell &cell, uint i, uint j);
-  bool checkTwinCell(Cell &cell, uint i, uint j);
+  bool checkLockedValues();
 
-  bool checkTripleValues();
-  bool checkTripleRow(Cell &cell, uint i, uint j);
-  bool checkTripleCol(Cell &cell, uint i, uint j);
-  bool checkTripleCell(Cell &cell, uint i, uint j);
+  bool checkSubsetValues(uint size, bool hidden);
+  bool checkSubsetUnit(uint u, uint size, bool hidden);
+
+  bool checkFishValues(uint size);
 
   bool checkValid();
   void newGame();
   void reset();
-  void loadGame(const char *str);
+  bool loadGame(const char *str);
+  bool loadGame(const char *str, size_t len);
+
+  // load record i of binary pack file (stored solution is used if present)
+  // and write initial values (and solution if file has them) to pack file
+  bool loadGame(const CSudokuPackReader &reader, ulong i);
+  bool writeGame(CSudokuPackWriter &writer, uint difficulty=0) const;
   bool isSolved();
 
   void print();
 
+  static uint charValue(char c);
+  static char valueChar(uint value);
+
  private:
-  bool genValues(Values &values);
+  void genValues(Values &values);
+
+  void removeClues(uint8_t *values, const uint *cells);
 
   void setInitValues();
 
   void init(const Values &values);
 
+  void resetValues();
+
+  bool placeValue(uint k, uint value);
+
+  bool removePeerValues(uint k, Mask mask);
+
+  bool removeSolvedValues(uint k, Mask mask);
+
+  uint markState() const { return uint(trail_.size()); }
+
+  void rewindState(uint mark);
+
   bool initSolution();
 
   bool initSolve();
   void initSolveValues();
-  bool solve1();
-  bool solveCell(uint i);
-  bool solveRow(uint i);
-  bool solveCol(uint i);
+  bool solve1(bool fixpoint=true);
+
+  bool propagate();
+
+  bool checkEliminations();
+
+  uint engineSolve(uint8_t *solution, uint limit=1);
+
+  static uint solveValues(const uint8_t *values, uint8_t *solution, uint limit,
+                          Engine engine, ulong &num_nodes, ulong max_nodes=0);
+
+  uint minValuesCell() const;
+
+  void iterCount(uint limit, uint &count);
 
-  void saveState();
-  void restoreState();
+  void splitSearch(uint depth, std::vector<Values> &subproblems);
+  void splitSubproblems(std::vector<Values> &subproblems);
 
-  void log(const std::string &msg) const;
+  CSudokuThreadPool &threadPool();
 
-  static std::string intToString(int i);
+  bool parallelIterSolve();
+  uint parallelIterCount(uint limit);
+
+  void placeSolution(const uint8_t *solution);
+
+  static bool findSubset(const Mask *masks, uint num_items, uint size, uint start,
+                         uint &subset, Mask &subset_mask);
+  bool solveUnit(uint u);
+
+  // events are only built when logging to a sink
+  bool logging() const { return (log_ && sink_); }
+
+  void logEvent(const CSudokuEvent &event) const { sink_->event(event); }
+
+  static CSudokuEvent::UnitType unitType(uint u) { return CSudokuEvent::UnitType(u / SIZE); }
 
  private:
-  Cell                cells_[SIZE][SIZE];
+  // working state (possible values, used values per unit and placed values)
+  // is kept together at the start of the board
+  alignas(64)
+  Mask                solve_values_[AREA];
+  Mask                unit_used_[NUM_UNITS];
+  uint8_t             values_[AREA];
+  uint8_t             init_values_[AREA];
+  uint8_t             solution_values_[AREA];
   bool                valid_;
   bool                log_;
-  std::vector<Values> saved_state_;
+  Engine              engine_;
+  uint                num_threads_;
+  uint                game_clues_;
+  std::unique_ptr<CSudokuThreadPool> pool_; // parallel search and clue removal (kept between calls)
+  ulong               num_nodes_;
+  std::vector<Change> trail_;
+  const std::atomic<bool> *cancel_; // stop search when set (parallel search)
+  CSudokuEventSink   *sink_;
+#ifdef CSUDOKU_STATS
+  CSudokuStats        stats_;
+  CSudokuStats        total_stats_; // stats of previous games
+  uint                stats_depth_ { 0 };
+#endif
 };
 
+// instantiated in CSudoku.cpp
+extern template class CSudokuT<3>;
+extern template class CSudokuT<4>;
+extern template class CSudokuT<5>;
+
+typedef CSudokuT<3> CSudoku;   //  9 x  9
+typedef CSudokuT<4> CSudoku16; // 16 x 16
+typedef CSudokuT<5> CSudoku25; // 25 x 25
+
 #endif
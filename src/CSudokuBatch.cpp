@@ -0,0 +1,492 @@
+// Headless batch solver.
+//
+// Reads one puzzle per line (from file or stdin) and writes its solution, or
+// "unsolvable", on the matching output line. Blank lines are skipped. With
+// -rate the line is the puzzle's difficulty rating instead ("<score> <hardest
+// technique> <guesses>", see CSudokuRating).
+//
+// Input files (text or binary pack files) are memory mapped and split into
+// blocks without copying lines (corrupt pack file records give a "corrupt"
+// line). Puzzles are solved in blocks spread over a work stealing thread pool
+// (one board per worker). Output keeps input order unless -unordered is
+// given, in which case each block is written as soon as it is solved.
+//
+//   CSudokuBatch [-engine strategy|dlx|bitboard] [-size 3|4|5]
+//                [-threads n] [-unordered] [-rate] [file|-]
+
+#include <CSudoku.h>
+#include <CSudokuCorpus.h>
+#include <CSudokuPack.h>
+#include <CSudokuThreadPool.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// output is collected and written in large blocks
+class CSudokuBatchOutput {
+ public:
+  enum { BUFFER_SIZE = 1<<16 };
+
+  CSudokuBatchOutput(FILE *fp=stdout) :
+   fp_(fp) {
+    buffer_.reserve(BUFFER_SIZE + 1024);
+  }
+
+ ~CSudokuBatchOutput() { flush(); }
+
+  void addText(const std::string &text) {
+    buffer_ += text;
+
+    if (buffer_.size() >= BUFFER_SIZE)
+      flush();
+  }
+
+  void flush() {
+    if (! buffer_.empty())
+      fwrite(buffer_.data(), 1, buffer_.size(), fp_);
+
+    fflush(fp_);
+
+    buffer_.clear();
+  }
+
+ private:
+  FILE        *fp_;
+  std::string  buffer_;
+};
+
+// solved blocks are written in block order (or as soon as they are solved if
+// not ordered) and the number of blocks in flight is limited so memory use
+// doesn't depend on input size
+class CSudokuBatchBlocks {
+ public:
+  CSudokuBatchBlocks(CSudokuBatchOutput &output, bool ordered, uint max_active) :
+   output_(output), ordered_(ordered), max_active_(max_active) {
+  }
+
+  // wait until another block can be started
+  void startBlock() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    cond_.wait(lock, [&]() { return num_active_ < max_active_; });
+
+    ++num_active_;
+  }
+
+  void endBlock(ulong block, std::string &text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (ordered_) {
+      solved_[block] = std::move(text);
+
+      for (auto p = solved_.find(next_write_); p != solved_.end(); p = solved_.find(next_write_)) {
+        output_.addText((*p).second);
+
+        solved_.erase(p);
+
+        ++next_write_;
+      }
+    }
+    else
+      output_.addText(text);
+
+    --num_active_;
+
+    cond_.notify_one();
+  }
+
+ private:
+  CSudokuBatchOutput           &output_;
+  bool                          ordered_;
+  uint                          max_active_;
+  std::mutex                    mutex_;
+  std::condition_variable       cond_;
+  std::map<ulong, std::string>  solved_;     // blocks waiting for earlier blocks
+  ulong                         next_write_ { 0 };
+  uint                          num_active_ { 0 };
+};
+
+enum { BLOCK_LINES       = 256    }; // lines per block read from stream
+enum { BLOCK_BYTES       = 256*82 }; // bytes per block of mapped file
+enum { BLOCKS_PER_THREAD = 4      };
+
+// add solution (or "unsolvable") line to text
+template<typename SUDOKU>
+void
+addSolution(const SUDOKU &sudoku, bool solved, std::string &text)
+{
+  if (! solved) {
+    text += "unsolvable\n";
+    return;
+  }
+
+  for (uint i = 0; i < SUDOKU::SIZE; ++i)
+    for (uint j = 0; j < SUDOKU::SIZE; ++j)
+      text += SUDOKU::valueChar(sudoku.getSolutionValue(i, j));
+
+  text += '\n';
+}
+
+// add rating (or "unsolvable") line to text
+template<typename SUDOKU>
+void
+addRating(SUDOKU &sudoku, bool solved, std::string &text)
+{
+  CSudokuRating rating;
+
+  if (solved)
+    rating = sudoku.rate();
+
+  if (! rating.solved) {
+    text += "unsolvable\n";
+    return;
+  }
+
+  text += std::to_string(rating.score) + ' ' +
+          CSudokuRating::techniqueName(rating.hardest) + ' ' +
+          std::to_string(rating.num_guesses) + '\n';
+}
+
+template<typename SUDOKU>
+void
+addResult(SUDOKU &sudoku, bool solved, bool rate, std::string &text)
+{
+  if (rate)
+    addRating(sudoku, solved, text);
+  else
+    addSolution(sudoku, solved, text);
+}
+
+// solve puzzle and add solution (or "unsolvable") line to text
+template<typename SUDOKU>
+void
+solveLine(SUDOKU &sudoku, const char *str, size_t len, bool rate, std::string &text)
+{
+  addResult(sudoku, sudoku.loadGame(str, len), rate, text);
+}
+
+template<typename SUDOKU>
+void
+solveChunk(SUDOKU &sudoku, CSudokuCorpus::Chunk chunk, bool rate, std::string &text)
+{
+  CSudokuCorpus::Line line;
+
+  while (chunk.nextLine(line))
+    solveLine(sudoku, line.str, line.len, rate, text);
+}
+
+// solve pack file records [start, end) ("corrupt" line for unreadable records)
+template<typename SUDOKU>
+void
+solveRecords(SUDOKU &sudoku, const CSudokuPackReader &reader, ulong start, ulong end,
+             bool rate, std::string &text)
+{
+  uint8_t values[SUDOKU::AREA], solution[SUDOKU::AREA];
+
+  for (ulong i = start; i < end; ++i) {
+    bool solved = sudoku.loadGame(reader, i);
+
+    // failed load is a corrupt record if it can't be read
+    if (! solved && ! reader.read(i, values, solution))
+      text += "corrupt\n";
+    else
+      addResult(sudoku, solved, rate, text);
+  }
+}
+
+// read next puzzle line (skipping blank lines)
+bool
+readLine(std::istream &is, std::string &line)
+{
+  while (std::getline(is, line)) {
+    if (! line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    if (! line.empty())
+      return true;
+  }
+
+  return false;
+}
+
+template<typename SUDOKU>
+void
+solveStream(std::istream &is, CSudokuBatchOutput &output, int engine, bool rate)
+{
+  SUDOKU sudoku;
+
+  sudoku.setEngine(typename SUDOKU::Engine(engine));
+
+  std::string line, text;
+
+  while (readLine(is, line)) {
+    text.clear();
+
+    solveLine(sudoku, line.c_str(), line.size(), rate, text);
+
+    output.addText(text);
+  }
+}
+
+// board owned by the calling pool worker, reused for all its blocks (thread
+// local as the board's members are over aligned)
+template<typename SUDOKU>
+SUDOKU &
+workerBoard(int engine)
+{
+  static thread_local SUDOKU sudoku;
+
+  sudoku.setEngine(typename SUDOKU::Engine(engine));
+
+  return sudoku;
+}
+
+template<typename SUDOKU>
+void
+solveStreamThreaded(std::istream &is, CSudokuBatchOutput &output, int engine, bool rate,
+                    uint num_threads, bool ordered)
+{
+  CSudokuThreadPool pool(num_threads);
+
+  CSudokuBatchBlocks blocks(output, ordered, BLOCKS_PER_THREAD*pool.getNumThreads());
+
+  std::string line;
+
+  for (ulong block = 0; ; ++block) {
+    std::vector<std::string> lines;
+
+    while (lines.size() < BLOCK_LINES && readLine(is, line))
+      lines.push_back(line);
+
+    if (lines.empty())
+      break;
+
+    blocks.startBlock();
+
+    pool.submit([&, block, lines = std::move(lines)](uint) {
+      SUDOKU &sudoku = workerBoard<SUDOKU>(engine);
+
+      std::string text;
+
+      for (const auto &line1 : lines)
+        solveLine(sudoku, line1.c_str(), line1.size(), rate, text);
+
+      blocks.endBlock(block, text);
+    });
+  }
+
+  pool.wait();
+}
+
+template<typename SUDOKU>
+void
+solveCorpus(const CSudokuCorpus &corpus, CSudokuBatchOutput &output, int engine, bool rate)
+{
+  SUDOKU sudoku;
+
+  sudoku.setEngine(typename SUDOKU::Engine(engine));
+
+  std::string text;
+
+  for (const auto &chunk : corpus.splitBySize(BLOCK_BYTES)) {
+    text.clear();
+
+    solveChunk(sudoku, chunk, rate, text);
+
+    output.addText(text);
+  }
+}
+
+// mapped file is split into blocks up front (lines are not copied)
+template<typename SUDOKU>
+void
+solveCorpusThreaded(const CSudokuCorpus &corpus, CSudokuBatchOutput &output, int engine,
+                    bool rate, uint num_threads, bool ordered)
+{
+  CSudokuThreadPool pool(num_threads);
+
+  CSudokuBatchBlocks blocks(output, ordered, BLOCKS_PER_THREAD*pool.getNumThreads());
+
+  std::vector<CSudokuCorpus::Chunk> chunks = corpus.splitBySize(BLOCK_BYTES);
+
+  for (ulong block = 0; block < chunks.size(); ++block) {
+    blocks.startBlock();
+
+    pool.submit([&, block](uint) {
+      SUDOKU &sudoku = workerBoard<SUDOKU>(engine);
+
+      std::string text;
+
+      solveChunk(sudoku, chunks[block], rate, text);
+
+      blocks.endBlock(block, text);
+    });
+  }
+
+  pool.wait();
+}
+
+template<typename SUDOKU>
+void
+solvePack(const CSudokuPackReader &reader, CSudokuBatchOutput &output, int engine,
+          bool rate, uint num_threads, bool ordered)
+{
+  ulong num_records = reader.getNumRecords();
+
+  if (num_threads == 1) {
+    SUDOKU sudoku;
+
+    sudoku.setEngine(typename SUDOKU::Engine(engine));
+
+    std::string text;
+
+    for (ulong i = 0; i < num_records; i += BLOCK_LINES) {
+      text.clear();
+
+      solveRecords(sudoku, reader, i, std::min(i + BLOCK_LINES, num_records), rate, text);
+
+      output.addText(text);
+    }
+
+    return;
+  }
+
+  CSudokuThreadPool pool(num_threads);
+
+  CSudokuBatchBlocks blocks(output, ordered, BLOCKS_PER_THREAD*pool.getNumThreads());
+
+  for (ulong block = 0; block*BLOCK_LINES < num_records; ++block) {
+    blocks.startBlock();
+
+    pool.submit([&, block](uint) {
+      SUDOKU &sudoku = workerBoard<SUDOKU>(engine);
+
+      std::string text;
+
+      ulong start = block*BLOCK_LINES;
+
+      solveRecords(sudoku, reader, start, std::min(start + BLOCK_LINES, num_records), rate,
+                   text);
+
+      blocks.endBlock(block, text);
+    });
+  }
+
+  pool.wait();
+}
+
+void
+usage()
+{
+  std::cerr << "Usage: CSudokuBatch [-engine strategy|dlx|bitboard] [-size 3|4|5]\n"
+               "                    [-threads n] [-unordered] [-rate] [file|-]\n";
+}
+
+}
+
+int
+main(int argc, char *argv[])
+{
+  int         engine      = CSudoku::ENGINE_BITBOARD;
+  uint        size        = 3;
+  uint        num_threads = 0;
+  bool        ordered     = true;
+  bool        rate        = false;
+  const char *filename    = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (strcmp(argv[i], "-engine") == 0 && i < argc - 1) {
+      ++i;
+
+      if      (strcmp(argv[i], "strategy") == 0) engine = CSudoku::ENGINE_STRATEGY;
+      else if (strcmp(argv[i], "dlx"     ) == 0) engine = CSudoku::ENGINE_DLX;
+      else if (strcmp(argv[i], "bitboard") == 0) engine = CSudoku::ENGINE_BITBOARD;
+      else { usage(); return 1; }
+    }
+    else if (strcmp(argv[i], "-size") == 0 && i < argc - 1) {
+      size = uint(atoi(argv[++i]));
+
+      if (size < 3 || size > 5) { usage(); return 1; }
+    }
+    else if (strcmp(argv[i], "-threads") == 0 && i < argc - 1) {
+      num_threads = uint(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-unordered") == 0) {
+      ordered = false;
+    }
+    else if (strcmp(argv[i], "-rate") == 0) {
+      rate = true;
+    }
+    else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      usage(); return 1;
+    }
+    else
+      filename = argv[i];
+  }
+
+  std::ios::sync_with_stdio(false);
+
+  CSudokuBatchOutput output;
+
+  // files are memory mapped, stdin is read as a stream
+  if (filename && strcmp(filename, "-") != 0) {
+    CSudokuPackReader reader;
+
+    if (reader.open(filename)) {
+      if (reader.getCellSize() != size) {
+        std::cerr << "Pack file cell size " << reader.getCellSize() << " doesn't match\n";
+        return 1;
+      }
+
+      if      (size == 3) solvePack<CSudoku  >(reader, output, engine, rate, num_threads, ordered);
+      else if (size == 4) solvePack<CSudoku16>(reader, output, engine, rate, num_threads, ordered);
+      else                solvePack<CSudoku25>(reader, output, engine, rate, num_threads, ordered);
+
+      return 0;
+    }
+
+    CSudokuCorpus corpus;
+
+    if (! corpus.open(filename)) {
+      std::cerr << "Failed to open '" << filename << "'\n";
+      return 1;
+    }
+
+    // one thread doesn't need the pool (0 is one thread per core)
+    if (num_threads == 1) {
+      if      (size == 3) solveCorpus<CSudoku  >(corpus, output, engine, rate);
+      else if (size == 4) solveCorpus<CSudoku16>(corpus, output, engine, rate);
+      else                solveCorpus<CSudoku25>(corpus, output, engine, rate);
+    }
+    else {
+      if      (size == 3) solveCorpusThreaded<CSudoku  >(corpus, output, engine, rate, num_threads, ordered);
+      else if (size == 4) solveCorpusThreaded<CSudoku16>(corpus, output, engine, rate, num_threads, ordered);
+      else                solveCorpusThreaded<CSudoku25>(corpus, output, engine, rate, num_threads, ordered);
+    }
+  }
+  else {
+    if (num_threads == 1) {
+      if      (size == 3) solveStream<CSudoku  >(std::cin, output, engine, rate);
+      else if (size == 4) solveStream<CSudoku16>(std::cin, output, engine, rate);
+      else                solveStream<CSudoku25>(std::cin, output, engine, rate);
+    }
+    else {
+      if      (size == 3) solveStreamThreaded<CSudoku  >(std::cin, output, engine, rate, num_threads, ordered);
+      else if (size == 4) solveStreamThreaded<CSudoku16>(std::cin, output, engine, rate, num_threads, ordered);
+      else                solveStreamThreaded<CSudoku25>(std::cin, output, engine, rate, num_threads, ordered);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,43 @@
+TEMPLATE = app
+
+CONFIG += console thread c++14
+CONFIG -= qt app_bundle
+
+TARGET = CSudokuBatch
+
+DEPENDPATH += .
+
+#CONFIG += debug
+
+# collect solver strategy statistics (CSudokuStats.h)
+#DEFINES += CSUDOKU_STATS
+
+# Input
+SOURCES += \
+CSudokuBatch.cpp \
+CSudoku.cpp \
+CSudokuEvents.cpp \
+CSudokuGenerator.cpp \
+CSudokuDLX.cpp \
+CSudokuBitBoard.cpp \
+CSudokuCorpus.cpp \
+CSudokuPack.cpp \
+CSudokuThreadPool.cpp \
+
+HEADERS += \
+CSudoku.h \
+CSudokuEvents.h \
+CSudokuGenerator.h \
+CSudokuRating.h \
+CSudokuStats.h \
+CSudokuDLX.h \
+CSudokuBitBoard.h \
+CSudokuCorpus.h \
+CSudokuPack.h \
+CSudokuThreadPool.h \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj/batch
+
+INCLUDEPATH += \
+.
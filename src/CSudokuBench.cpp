@@ -0,0 +1,392 @@
+// Solver benchmark.
+//
+// Runs solve(), solvable(), rate() and newGame() over built-in 9x9 puzzle sets and
+// writes throughput, per call latency (mean, median and 99th percentile) and
+// search nodes per puzzle as JSON on stdout.
+//
+// Puzzles are loaded before each timed call (loadGame also calculates the
+// solution so setup isn't timed). When built with CSUDOKU_STATS defined each
+// result also has the solver's strategy statistics.
+//
+//   CSudokuBench [-engine strategy|dlx|bitboard] [-threads n] [-repeat n]
+//                [-games n] [-clues n] [-set easy|hard|17clue|pathological]
+//                [-op solve|solvable|rate|newgame]
+
+#include <CSudoku.h>
+#include <CSudokuBitBoard.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// puzzles solved with little or no search
+const char *easyPuzzles[] = {
+  "029085007085070239700930500030009400000000000006400010008047001561090370400510890",
+  "060009080000008063048350000090000000600803001000000070000062910820900000070400030",
+  "003020600900305001001806400008102900700000008006708200002609500800203009005010300",
+  "200080300060070084030500209000105408000000000402706000301007040720040060004010003",
+  "000000907000420180000705026100904000050000040000507009920108000034059000507000000",
+  "030050040008010500460000012070502080000603000040109030250000098001020600080060020",
+  "020810740700003100090002805009040087400208003160030200302700060005600008076051090",
+  "100920000524010000000000070050008102000000000402700090060000000000030945000071006",
+  "043080250600000000000001094900004070000608000010200003820500000000000005034090710",
+  "480006902002008001900370060840010200003704100001060049020085007700900600609200018",
+  "000900002050123400030000160908000000070000090000000205091000050007439020400007000",
+  "001900003900700160030005007050000009004302600200000070600100030042007006500006800",
+};
+
+// puzzles needing search or advanced strategies
+const char *hardPuzzles[] = {
+  "800000000003600000070090200050007000000045700000100030001000068008500010090000400",
+  "1....7.9..3..2...8..96..5....53..9...1..8...26....4...3......1..4......7..7...3..",
+  "1.......2.9.4...5...6...7...5.9.3.......7.......85..4.7.....6...3...9.8...2.....1",
+  "4.....8.5.3..........7......2.....6.....8.4......1.......6.3.7.5..2.....1.4......",
+  "52...6.........7.13...........4..8..6......5...........418.........3..2...87.....",
+  "6.....8.3.4.7.................5.4.7.3..2.....1.6.......2.....5.....8.6......1....",
+  "48.3............71.2.......7.5....6....2..8.............1.76...3.....4......5....",
+  "..53.....8......2..7..1.5..4....53...1..7...6..32...8..6.5....9..4....3......97..",
+  "12.3....435....1....4........54..2..6...7.........8.9...31..5.......9.7.....6...8",
+};
+
+// minimal (17 given) puzzles with a unique solution
+const char *clue17Puzzles[] = {
+  "000000010400000000020000000000050407008000300001090000300400200050100000000806000",
+  "000000010400000000020000000000050604008000300001090000300400200050100000000807000",
+  "000000012000035000000600070700000300000400800100000000000120000080000040050000600",
+  "000000012003600000000007000410020000000500300700000600280000040000300500000000000",
+  "000000012008030000000000040120500000000004700060000000507000300000620000000100000",
+  "000000012040050000000009000070600400000100000000000050000087500601000300200000000",
+  "000000012050400000000000030700600400001000000000080000920000800000510700000003000",
+  "000000012300000060000040000900000500000001070020000000000350400001400800060000000",
+  "000000012400090000000000050070200000600000400000108000018000000000030700502000000",
+  "000000012500008000000700000600120000700000450000030000030000800000500700020000000",
+};
+
+// puzzles built to defeat backtracking: first row solution 987654321 (worst case
+// for in order search), many solutions in a large search space, no solution
+// (only found by exhausting the search) and the empty grid
+const char *pathologicalPuzzles[] = {
+  "..............3.85..1.2.......5.7.....4...1...9.......5......73..2.1........4...9",
+  ".....6....59.....82....8....45........3........6..3.54...325..6..................",
+  ".....5.8....6.1.43..........1.5........1.6...3.......553.....61........4.........",
+  ".................................................................................",
+};
+
+struct PuzzleSet {
+  const char  *name;
+  const char **puzzles;
+  uint         num_puzzles;
+};
+
+#define PUZZLE_SET(name, puzzles) { name, puzzles, sizeof(puzzles)/sizeof(puzzles[0]) }
+
+const PuzzleSet puzzleSets[] = {
+  PUZZLE_SET("easy"        , easyPuzzles),
+  PUZZLE_SET("hard"        , hardPuzzles),
+  PUZZLE_SET("17clue"      , clue17Puzzles),
+  PUZZLE_SET("pathological", pathologicalPuzzles),
+};
+
+enum { NUM_PUZZLE_SETS = sizeof(puzzleSets)/sizeof(puzzleSets[0]) };
+
+typedef std::chrono::steady_clock Clock;
+
+// timing and node counts of calls of one operation
+class CSudokuBenchResult {
+ public:
+  CSudokuBenchResult(const std::string &set, const std::string &op, uint num_puzzles) :
+   set_(set), op_(op), num_puzzles_(num_puzzles) {
+  }
+
+  void addCall(double seconds, ulong num_nodes, bool solved) {
+    times_.push_back(seconds);
+
+    num_nodes_ += num_nodes;
+
+    if (solved)
+      ++num_solved_;
+  }
+
+#ifdef CSUDOKU_STATS
+  void addStats(const CSudokuStats &stats) { stats_ += stats; }
+#endif
+
+  std::string toJson() const {
+    std::vector<double> times = times_;
+
+    std::sort(times.begin(), times.end());
+
+    double total = 0.0;
+
+    for (const auto &t : times)
+      total += t;
+
+    uint num_calls = uint(times.size());
+
+    double mean = (num_calls ? total/num_calls : 0.0);
+
+    char buffer[512];
+
+    snprintf(buffer, sizeof(buffer),
+      "{\"set\": \"%s\", \"op\": \"%s\", \"puzzles\": %u, \"calls\": %u, "
+      "\"solved\": %u, \"seconds\": %.6f, \"puzzles_per_sec\": %.1f, "
+      "\"mean_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f, "
+      "\"nodes_per_puzzle\": %.1f",
+      set_.c_str(), op_.c_str(), num_puzzles_, num_calls, num_solved_, total,
+      (total > 0.0 ? num_calls/total : 0.0), 1e6*mean,
+      1e6*percentile(times, 50), 1e6*percentile(times, 99),
+      (num_calls ? double(num_nodes_)/num_calls : 0.0));
+
+    std::string json = buffer;
+
+#ifdef CSUDOKU_STATS
+    json += ", \"stats\": {";
+
+    for (uint i = 0; i < CSudokuStats::NUM_STRATEGIES; ++i) {
+      CSudokuStats::Strategy s = CSudokuStats::Strategy(i);
+
+      const CSudokuStats::StrategyStats &stats = stats_.strategy(s);
+
+      snprintf(buffer, sizeof(buffer),
+        "\"%s\": {\"calls\": %lu, \"successes\": %lu, \"changes\": %lu, "
+        "\"seconds\": %.6f}, ",
+        CSudokuStats::strategyName(s), stats.calls, stats.successes, stats.changes,
+        stats.seconds);
+
+      json += buffer;
+    }
+
+    snprintf(buffer, sizeof(buffer),
+      "\"search\": {\"nodes\": %lu, \"backtracks\": %lu, \"max_depth\": %u}}",
+      stats_.search.nodes, stats_.search.backtracks, stats_.search.max_depth);
+
+    json += buffer;
+#endif
+
+    json += "}";
+
+    return json;
+  }
+
+ private:
+  // nearest rank percentile of sorted times
+  static double percentile(const std::vector<double> &times, uint p) {
+    if (times.empty())
+      return 0.0;
+
+    size_t rank = (p*times.size() + 99)/100;
+
+    return times[std::max(rank, size_t(1)) - 1];
+  }
+
+ private:
+  std::string         set_;
+  std::string         op_;
+  uint                num_puzzles_;
+  std::vector<double> times_;
+  ulong               num_nodes_  { 0 };
+  uint                num_solved_ { 0 };
+#ifdef CSUDOKU_STATS
+  CSudokuStats        stats_;
+#endif
+};
+
+double
+elapsed(const Clock::time_point &start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// time solve(), solvable() or rate() of each puzzle of set
+CSudokuBenchResult
+benchSet(const PuzzleSet &set, const std::string &op, int engine,
+         uint num_threads, uint repeat)
+{
+  CSudokuBenchResult result(set.name, op, set.num_puzzles);
+
+  CSudoku sudoku;
+
+  sudoku.setEngine(CSudoku::Engine(engine));
+  sudoku.setNumThreads(num_threads);
+
+  for (uint r = 0; r < repeat; ++r) {
+    for (uint i = 0; i < set.num_puzzles; ++i) {
+      sudoku.loadGame(set.puzzles[i]);
+
+      ulong num_nodes = sudoku.getNumNodes();
+
+#ifdef CSUDOKU_STATS
+      sudoku.resetStats();
+#endif
+
+      Clock::time_point start = Clock::now();
+
+      bool solved;
+
+      if      (op == "solve") solved = sudoku.solve();
+      else if (op == "rate" ) solved = sudoku.rate().solved;
+      else                    solved = sudoku.solvable();
+
+      double seconds = elapsed(start);
+
+      result.addCall(seconds, sudoku.getNumNodes() - num_nodes, solved);
+
+#ifdef CSUDOKU_STATS
+      result.addStats(sudoku.getStats());
+#endif
+    }
+  }
+
+  return result;
+}
+
+// time generation of new games (fixed seed so runs are comparable)
+CSudokuBenchResult
+benchNewGame(int engine, uint num_threads, uint num_games, uint num_clues)
+{
+  CSudokuBenchResult result("generated", "newgame", num_games);
+
+  CSudoku sudoku;
+
+  sudoku.setEngine(CSudoku::Engine(engine));
+  sudoku.setNumThreads(num_threads);
+  sudoku.setGameClues(num_clues);
+
+  srand(1);
+
+  for (uint i = 0; i < num_games; ++i) {
+    ulong num_nodes = sudoku.getNumNodes();
+
+    Clock::time_point start = Clock::now();
+
+    sudoku.newGame();
+
+    double seconds = elapsed(start);
+
+    result.addCall(seconds, sudoku.getNumNodes() - num_nodes, sudoku.getValid());
+
+#ifdef CSUDOKU_STATS
+    result.addStats(sudoku.getStats());
+#endif
+  }
+
+  return result;
+}
+
+const char *
+engineName(int engine)
+{
+  if      (engine == CSudoku::ENGINE_STRATEGY) return "strategy";
+  else if (engine == CSudoku::ENGINE_DLX     ) return "dlx";
+  else                                         return "bitboard";
+}
+
+void
+usage()
+{
+  std::cerr << "Usage: CSudokuBench [-engine strategy|dlx|bitboard] [-threads n] [-repeat n]\n"
+               "                    [-games n] [-clues n] [-set easy|hard|17clue|pathological]\n"
+               "                    [-op solve|solvable|rate|newgame]\n";
+}
+
+}
+
+int
+main(int argc, char *argv[])
+{
+  int         engine      = CSudoku::ENGINE_BITBOARD;
+  uint        num_threads = 1;
+  uint        repeat      = 1;
+  uint        num_games   = 10;
+  uint        num_clues   = 0;
+  std::string set_name;
+  std::string op_name;
+
+  for (int i = 1; i < argc; ++i) {
+    if      (strcmp(argv[i], "-engine") == 0 && i < argc - 1) {
+      ++i;
+
+      if      (strcmp(argv[i], "strategy") == 0) engine = CSudoku::ENGINE_STRATEGY;
+      else if (strcmp(argv[i], "dlx"     ) == 0) engine = CSudoku::ENGINE_DLX;
+      else if (strcmp(argv[i], "bitboard") == 0) engine = CSudoku::ENGINE_BITBOARD;
+      else { usage(); return 1; }
+    }
+    else if (strcmp(argv[i], "-threads") == 0 && i < argc - 1) {
+      num_threads = uint(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-repeat") == 0 && i < argc - 1) {
+      repeat = uint(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-games") == 0 && i < argc - 1) {
+      num_games = uint(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-clues") == 0 && i < argc - 1) {
+      num_clues = uint(atoi(argv[++i]));
+    }
+    else if (strcmp(argv[i], "-set") == 0 && i < argc - 1) {
+      set_name = argv[++i];
+    }
+    else if (strcmp(argv[i], "-op") == 0 && i < argc - 1) {
+      op_name = argv[++i];
+
+      if (op_name != "solve" && op_name != "solvable" && op_name != "rate" &&
+          op_name != "newgame") {
+        usage(); return 1;
+      }
+    }
+    else {
+      usage(); return 1;
+    }
+  }
+
+  std::vector<CSudokuBenchResult> results;
+
+  bool found_set = set_name.empty();
+
+  for (uint s = 0; s < NUM_PUZZLE_SETS; ++s) {
+    const PuzzleSet &set = puzzleSets[s];
+
+    if (! set_name.empty() && set_name != set.name) continue;
+
+    found_set = true;
+
+    if (op_name.empty() || op_name == "solve")
+      results.push_back(benchSet(set, "solve", engine, num_threads, repeat));
+
+    if (op_name.empty() || op_name == "solvable")
+      results.push_back(benchSet(set, "solvable", engine, num_threads, repeat));
+
+    if (op_name.empty() || op_name == "rate")
+      results.push_back(benchSet(set, "rate", engine, num_threads, repeat));
+  }
+
+  if (! found_set) {
+    usage(); return 1;
+  }
+
+  if (set_name.empty() && (op_name.empty() || op_name == "newgame"))
+    results.push_back(benchNewGame(engine, num_threads, num_games, num_clues));
+
+  std::cout << "{\n";
+  std::cout << "  \"engine\": \"" << engineName(engine) << "\",\n";
+  std::cout << "  \"kernel\": \"" << CSudokuBitBoard::kernelName() << "\",\n";
+  std::cout << "  \"threads\": " << num_threads << ",\n";
+  std::cout << "  \"repeat\": " << repeat << ",\n";
+  std::cout << "  \"results\": [\n";
+
+  for (size_t i = 0; i < results.size(); ++i)
+    std::cout << "    " << results[i].toJson() << (i + 1 < results.size() ? ",\n" : "\n");
+
+  std::cout << "  ]\n";
+  std::cout << "}\n";
+
+  return 0;
+}
@@ -0,0 +1,41 @@
+TEMPLATE = app
+
+CONFIG += console thread c++14
+CONFIG -= qt app_bundle
+
+TARGET = CSudokuBench
+
+DEPENDPATH += .
+
+#CONFIG += debug
+
+# collect solver strategy statistics (CSudokuStats.h)
+#DEFINES += CSUDOKU_STATS
+
+# Input
+SOURCES += \
+CSudokuBench.cpp \
+CSudoku.cpp \
+CSudokuEvents.cpp \
+CSudokuGenerator.cpp \
+CSudokuDLX.cpp \
+CSudokuBitBoard.cpp \
+CSudokuPack.cpp \
+CSudokuThreadPool.cpp \
+
+HEADERS += \
+CSudoku.h \
+CSudokuEvents.h \
+CSudokuGenerator.h \
+CSudokuRating.h \
+CSudokuStats.h \
+CSudokuDLX.h \
+CSudokuBitBoard.h \
+CSudokuPack.h \
+CSudokuThreadPool.h \
+
+DESTDIR     = ../bin
+OBJECTS_DIR = ../obj/bench
+
+INCLUDEPATH += \
+.
@@ -0,0 +1,448 @@
+#include <CSudokuBitBoard.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <emmintrin.h>
+
+#define CSUDOKU_BIT_BOARD_SSE 1
+#endif
+
+// kernel helpers are inlined into the search loop
+#ifdef __GNUC__
+#define CSUDOKU_BIT_BOARD_INLINE inline __attribute__((always_inline))
+#else
+#define CSUDOKU_BIT_BOARD_INLINE inline
+#endif
+
+namespace {
+
+enum { SIZE      = 9         };
+enum { CELL_SIZE = 3         };
+enum { AREA      = SIZE*SIZE };
+enum { NUM_UNITS = 3*SIZE    };
+
+// 81 bit cell mask as pair of 64 bit words (cell k is bit k)
+struct Mask81 {
+  uint64_t lo { 0 };
+  uint64_t hi { 0 };
+};
+
+// cell, peer and unit masks (and mask of units containing each cell)
+struct BitBoardTables {
+  alignas(16) Mask81 cell [AREA];
+  alignas(16) Mask81 peers[AREA];
+  alignas(16) Mask81 units[NUM_UNITS];
+  alignas(16) Mask81 all;
+
+  uint32_t cell_units[AREA];
+
+  constexpr BitBoardTables() :
+   cell(), peers(), units(), all(), cell_units() {
+    for (uint k = 0; k < AREA; ++k) {
+      setBit(cell[k], k);
+      setBit(all    , k);
+    }
+
+    for (uint k = 0; k < AREA; ++k) {
+      uint i = k / SIZE;
+      uint j = k % SIZE;
+      uint b = (i / CELL_SIZE) + CELL_SIZE*(j / CELL_SIZE);
+
+      setBit(units[i         ], k);
+      setBit(units[SIZE + j  ], k);
+      setBit(units[2*SIZE + b], k);
+
+      cell_units[k] = (1U << i) | (1U << (SIZE + j)) | (1U << (2*SIZE + b));
+
+      for (uint k1 = 0; k1 < AREA; ++k1) {
+        if (k1 == k) continue;
+
+        uint i1 = k1 / SIZE;
+        uint j1 = k1 % SIZE;
+        uint b1 = (i1 / CELL_SIZE) + CELL_SIZE*(j1 / CELL_SIZE);
+
+        if (i1 == i || j1 == j || b1 == b)
+          setBit(peers[k], k1);
+      }
+    }
+  }
+
+  static constexpr void setBit(Mask81 &m, uint k) {
+    if (k < 64)
+      m.lo |= (uint64_t(1) << k);
+    else
+      m.hi |= (uint64_t(1) << (k - 64));
+  }
+};
+
+constexpr BitBoardTables bitBoardTables;
+
+//------
+
+#ifdef CSUDOKU_BIT_BOARD_SSE
+// 128-bit SIMD word
+struct Bits {
+  __m128i v;
+};
+
+CSUDOKU_BIT_BOARD_INLINE Bits loadBits(const Mask81 &m) {
+  return Bits { _mm_load_si128(reinterpret_cast<const __m128i *>(&m)) };
+}
+
+CSUDOKU_BIT_BOARD_INLINE Bits zeroBits() { return Bits { _mm_setzero_si128() }; }
+
+CSUDOKU_BIT_BOARD_INLINE Bits operator&(const Bits &a, const Bits &b) { return Bits { _mm_and_si128(a.v, b.v) }; }
+CSUDOKU_BIT_BOARD_INLINE Bits operator|(const Bits &a, const Bits &b) { return Bits { _mm_or_si128 (a.v, b.v) }; }
+
+// a & ~b
+CSUDOKU_BIT_BOARD_INLINE Bits andNot(const Bits &a, const Bits &b) { return Bits { _mm_andnot_si128(b.v, a.v) }; }
+
+CSUDOKU_BIT_BOARD_INLINE bool isZero(const Bits &a) {
+  return (_mm_movemask_epi8(_mm_cmpeq_epi8(a.v, _mm_setzero_si128())) == 0xFFFF);
+}
+
+CSUDOKU_BIT_BOARD_INLINE uint64_t loWord(const Bits &a) { return uint64_t(_mm_cvtsi128_si64(a.v)); }
+CSUDOKU_BIT_BOARD_INLINE uint64_t hiWord(const Bits &a) { return uint64_t(_mm_cvtsi128_si64(_mm_unpackhi_epi64(a.v, a.v))); }
+#else
+// scalar fallback (pair of 64-bit words)
+struct Bits {
+  uint64_t lo, hi;
+};
+
+CSUDOKU_BIT_BOARD_INLINE Bits loadBits(const Mask81 &m) { return Bits { m.lo, m.hi }; }
+
+CSUDOKU_BIT_BOARD_INLINE Bits zeroBits() { return Bits { 0, 0 }; }
+
+CSUDOKU_BIT_BOARD_INLINE Bits operator&(const Bits &a, const Bits &b) { return Bits { a.lo & b.lo, a.hi & b.hi }; }
+CSUDOKU_BIT_BOARD_INLINE Bits operator|(const Bits &a, const Bits &b) { return Bits { a.lo | b.lo, a.hi | b.hi }; }
+
+CSUDOKU_BIT_BOARD_INLINE Bits andNot(const Bits &a, const Bits &b) { return Bits { a.lo & ~b.lo, a.hi & ~b.hi }; }
+
+CSUDOKU_BIT_BOARD_INLINE bool isZero(const Bits &a) { return ! (a.lo | a.hi); }
+
+CSUDOKU_BIT_BOARD_INLINE uint64_t loWord(const Bits &a) { return a.lo; }
+CSUDOKU_BIT_BOARD_INLINE uint64_t hiWord(const Bits &a) { return a.hi; }
+#endif
+
+CSUDOKU_BIT_BOARD_INLINE bool testBit(const Bits &a, uint k) {
+  return (k < 64 ? (loWord(a) >> k) & 1 : (hiWord(a) >> (k - 64)) & 1);
+}
+
+CSUDOKU_BIT_BOARD_INLINE uint countBits(const Bits &a) {
+  return uint(__builtin_popcountll(loWord(a)) + __builtin_popcountll(hiWord(a)));
+}
+
+// index of lowest set bit (a must be non-zero)
+CSUDOKU_BIT_BOARD_INLINE uint lowestBit(const Bits &a) {
+  uint64_t lo = loWord(a);
+
+  if (lo)
+    return uint(__builtin_ctzll(lo));
+
+  return 64 + uint(__builtin_ctzll(hiWord(a)));
+}
+
+// check if only one bit set (a must be non-zero)
+CSUDOKU_BIT_BOARD_INLINE bool isSingleBit(const Bits &a) {
+  uint64_t lo = loWord(a);
+  uint64_t hi = hiWord(a);
+
+  if (lo)
+    return (! hi && ! (lo & (lo - 1)));
+
+  return ! (hi & (hi - 1));
+}
+
+//------
+
+// board state (candidate cells for each digit, placed digits stay set in their plane)
+struct BitBoard {
+  Bits     planes[SIZE];
+  Bits     solved;
+  uint32_t solved_units[SIZE]; // units each digit has been placed in
+};
+
+CSUDOKU_BIT_BOARD_INLINE void placeDigit(BitBoard &board, uint k, uint d) {
+  Bits cell = loadBits(bitBoardTables.cell[k]);
+
+  for (uint d1 = 0; d1 < SIZE; ++d1)
+    board.planes[d1] = andNot(board.planes[d1], cell);
+
+  board.planes[d] = andNot(board.planes[d], loadBits(bitBoardTables.peers[k])) | cell;
+
+  board.solved = board.solved | cell;
+
+  board.solved_units[d] |= bitBoardTables.cell_units[k];
+}
+
+// place naked and hidden singles until no more found (false if contradiction)
+CSUDOKU_BIT_BOARD_INLINE bool propagate(BitBoard &board) {
+  Bits all = loadBits(bitBoardTables.all);
+
+  while (true) {
+    // cells with one candidate (once but not twice) and cells with none
+    Bits once  = zeroBits();
+    Bits twice = zeroBits();
+
+    for (uint d = 0; d < SIZE; ++d) {
+      twice = twice | (once & board.planes[d]);
+      once  = once  | board.planes[d];
+    }
+
+    if (! isZero(andNot(all, once)))
+      return false;
+
+    Bits singles = andNot(andNot(once, twice), board.solved);
+
+    if (! isZero(singles)) {
+      do {
+        uint k = lowestBit(singles);
+
+        singles = andNot(singles, loadBits(bitBoardTables.cell[k]));
+
+        // candidate may have been removed by earlier single (found on next pass)
+        for (uint d = 0; d < SIZE; ++d) {
+          if (testBit(board.planes[d], k)) {
+            placeDigit(board, k, d);
+            break;
+          }
+        }
+      } while (! isZero(singles));
+
+      continue;
+    }
+
+    // digits with only one place in a unit they have not been placed in
+    bool changed = false;
+
+    for (uint d = 0; d < SIZE; ++d) {
+      uint32_t open_units = ~board.solved_units[d] & ((1U << NUM_UNITS) - 1);
+
+      for ( ; open_units; open_units &= open_units - 1) {
+        uint u = uint(__builtin_ctz(open_units));
+
+        Bits m = board.planes[d] & loadBits(bitBoardTables.units[u]);
+
+        if (isZero(m))
+          return false;
+
+        if (! isSingleBit(m)) continue;
+
+        placeDigit(board, lowestBit(m), d);
+
+        open_units &= ~board.solved_units[d];
+
+        changed = true;
+      }
+    }
+
+    if (! changed)
+      return true;
+  }
+}
+
+// search branch at level: digits to try in a cell, or cells to try for a
+// digit in a unit
+struct Branch {
+  Bits places; // cells still to try for digit (branch on digit)
+  uint cell;   // cell (AREA if branch on digit)
+  uint digits; // digits still to try for cell (digit if branch on digit)
+};
+
+// branch on the unsolved cell with fewest candidates, or on the digit with
+// fewest places in a unit if that gives fewer choices
+CSUDOKU_BIT_BOARD_INLINE void chooseBranch(const BitBoard &board, Branch &branch) {
+  Bits once   = zeroBits();
+  Bits twice  = zeroBits();
+  Bits thrice = zeroBits();
+
+  for (uint d = 0; d < SIZE; ++d) {
+    thrice = thrice | (twice & board.planes[d]);
+    twice  = twice  | (once  & board.planes[d]);
+    once   = once   | board.planes[d];
+  }
+
+  Bits unsolved = andNot(loadBits(bitBoardTables.all), board.solved);
+
+  Bits pairs = andNot(twice, thrice) & unsolved;
+
+  uint k = lowestBit(! isZero(pairs) ? pairs : unsolved);
+
+  branch.cell   = k;
+  branch.digits = 0;
+
+  for (uint d = 0; d < SIZE; ++d)
+    if (testBit(board.planes[d], k))
+      branch.digits |= (1U << d);
+
+  // pair can't be beaten (propagate leaves at least two places per open unit)
+  uint num_choices = uint(__builtin_popcount(branch.digits));
+
+  if (num_choices <= 2)
+    return;
+
+  for (uint d = 0; d < SIZE; ++d) {
+    uint32_t open_units = ~board.solved_units[d] & ((1U << NUM_UNITS) - 1);
+
+    for ( ; open_units; open_units &= open_units - 1) {
+      uint u = uint(__builtin_ctz(open_units));
+
+      Bits m = board.planes[d] & loadBits(bitBoardTables.units[u]);
+
+      uint n = countBits(m);
+
+      if (n >= num_choices) continue;
+
+      num_choices = n;
+
+      branch.places = m;
+      branch.cell   = AREA;
+      branch.digits = d;
+
+      if (n <= 2)
+        return;
+    }
+  }
+}
+
+uint solveBoard(const uint8_t *values, uint8_t *solution, uint limit, ulong *num_nodes) {
+  // search stack (each level places at least one cell)
+  BitBoard boards  [AREA + 1];
+  Branch   branches[AREA + 1];
+
+  BitBoard &board = boards[0];
+
+  for (uint d = 0; d < SIZE; ++d)
+    board.planes[d] = loadBits(bitBoardTables.all);
+
+  board.solved = zeroBits();
+
+  for (uint d = 0; d < SIZE; ++d)
+    board.solved_units[d] = 0;
+
+  for (uint k = 0; k < AREA; ++k) {
+    uint value = values[k];
+
+    if (value == 0) continue;
+
+    // fail if value no longer possible (duplicate)
+    if (! testBit(board.planes[value - 1], k))
+      return 0;
+
+    placeDigit(board, k, value - 1);
+  }
+
+  if (! propagate(board))
+    return 0;
+
+  uint  num_solutions = 0;
+  ulong nodes         = 0;
+
+  int depth = 0;
+
+  bool next = true; // new board at depth to examine
+
+  while (depth >= 0) {
+    if (next) {
+      const BitBoard &board1 = boards[depth];
+
+      if (isZero(andNot(loadBits(bitBoardTables.all), board1.solved))) {
+        // solved
+        if (num_solutions == 0 && solution) {
+          for (uint d = 0; d < SIZE; ++d) {
+            for (uint k = 0; k < AREA; ++k)
+              if (testBit(board1.planes[d], k))
+                solution[k] = uint8_t(d + 1);
+          }
+        }
+
+        ++num_solutions;
+
+        if (num_solutions >= limit)
+          break;
+
+        --depth;
+      }
+      else {
+        chooseBranch(board1, branches[depth]);
+      }
+
+      next = false;
+
+      continue;
+    }
+
+    // try next digit in cell (or cell for digit) at level (backtrack if none
+    // left)
+    Branch &branch = branches[depth];
+
+    uint k, d;
+
+    if (branch.cell < AREA) {
+      if (branch.digits == 0) {
+        --depth;
+        continue;
+      }
+
+      k = branch.cell;
+      d = uint(__builtin_ctz(branch.digits));
+
+      branch.digits &= branch.digits - 1;
+    }
+    else {
+      if (isZero(branch.places)) {
+        --depth;
+        continue;
+      }
+
+      k = lowestBit(branch.places);
+      d = branch.digits;
+
+      branch.places = andNot(branch.places, loadBits(bitBoardTables.cell[k]));
+    }
+
+    BitBoard &board1 = boards[depth + 1];
+
+    board1 = boards[depth];
+
+    placeDigit(board1, k, d);
+
+    ++nodes;
+
+    if (propagate(board1)) {
+      ++depth;
+
+      next = true;
+    }
+  }
+
+  if (num_nodes)
+    *num_nodes = nodes;
+
+  return num_solutions;
+}
+
+}
+
+//------
+
+uint
+CSudokuBitBoard::
+solve(const uint8_t *values, uint8_t *solution, uint limit, ulong *num_nodes)
+{
+  // no nodes if grid is invalid before search
+  if (num_nodes)
+    *num_nodes = 0;
+
+  return solveBoard(values, solution, (limit > 0 ? limit : 1), num_nodes);
+}
+
+const char *
+CSudokuBitBoard::
+kernelName()
+{
+#ifdef CSUDOKU_BIT_BOARD_SSE
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef CSUDOKU_BIT_BOARD_H
+#define CSUDOKU_BIT_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// high throughput 9x9 solver kernel
+//
+// Candidates are held as nine 81-bit digit planes (one 128-bit word per digit)
+// and naked/hidden singles are propagated across all cells at once with 128-bit
+// SIMD operations. A depth first search is used when propagation gets stuck,
+// branching on the cell with fewest candidates or on the digit with fewest
+// places in a unit, whichever gives fewer choices.
+//
+// On x86-64 the kernel uses SSE2 (one 128-bit register per plane, so wider
+// instruction sets give no benefit). Other architectures use a scalar (two
+// 64-bit word) implementation.
+class CSudokuBitBoard {
+ public:
+  // solve grid of values (0 if unknown) stopping after limit solutions.
+  // Returns the number of solutions found and (if not NULL) sets solution to
+  // the first one. If num_nodes is not NULL it is set to the number of
+  // digits tried by the search.
+  static uint solve(const uint8_t *values, uint8_t *solution=NULL, uint limit=1,
+                    ulong *num_nodes=NULL);
+
+  // name of kernel implementation ("sse2" or "scalar")
+  static const char *kernelName();
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include <CSudokuCorpus.h>
+
+#include <algorithm>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool
+CSudokuCorpus::Chunk::
+nextLine(Line &line)
+{
+  while (pos_ < end_) {
+    const char *str = pos_;
+    const char *eol = static_cast<const char *>(memchr(str, '\n', size_t(end_ - str)));
+
+    if (! eol)
+      eol = end_;
+
+    pos_ = (eol < end_ ? eol + 1 : end_);
+
+    size_t len = size_t(eol - str);
+
+    if (len > 0 && str[len - 1] == '\r')
+      --len;
+
+    if (len == 0) continue;
+
+    line.str = str;
+    line.len = len;
+
+    return true;
+  }
+
+  return false;
+}
+
+//------
+
+CSudokuCorpus::
+CSudokuCorpus() :
+ fd_(-1), data_(NULL), size_(0)
+{
+}
+
+CSudokuCorpus::
+~CSudokuCorpus()
+{
+  close();
+}
+
+bool
+CSudokuCorpus::
+open(const std::string &filename)
+{
+  close();
+
+  int fd = ::open(filename.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  fd_   = fd;
+  size_ = size_t(st.st_size);
+
+  // empty file can't be mapped (and has no lines)
+  if (size_ == 0)
+    return true;
+
+  void *data = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+
+  if (data == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  // lines are read in order so let the kernel read ahead
+  madvise(data, size_, MADV_SEQUENTIAL);
+
+  data_ = static_cast<const char *>(data);
+
+  return true;
+}
+
+void
+CSudokuCorpus::
+close()
+{
+  if (data_)
+    munmap(const_cast<char *>(data_), size_);
+
+  if (fd_ >= 0)
+    ::close(fd_);
+
+  fd_   = -1;
+  data_ = NULL;
+  size_ = 0;
+}
+
+std::vector<CSudokuCorpus::Chunk>
+CSudokuCorpus::
+split(uint num_chunks) const
+{
+  if (num_chunks == 0)
+    num_chunks = 1;
+
+  return splitBySize((size_ + num_chunks - 1)/num_chunks);
+}
+
+std::vector<CSudokuCorpus::Chunk>
+CSudokuCorpus::
+splitBySize(size_t chunk_size) const
+{
+  std::vector<Chunk> chunks;
+
+  if (chunk_size == 0)
+    chunk_size = 1;
+
+  const char *begin = data_;
+  const char *end   = data_ + size_;
+
+  while (begin < end) {
+    // end chunk after the line ending nearest chunk size
+    const char *chunk_end = begin + std::min(chunk_size, size_t(end - begin));
+
+    if (chunk_end < end) {
+      const char *eol = static_cast<const char *>(memchr(chunk_end - 1, '\n', size_t(end - chunk_end + 1)));
+
+      chunk_end = (eol ? eol + 1 : end);
+    }
+
+    chunks.push_back(Chunk(begin, chunk_end));
+
+    begin = chunk_end;
+  }
+
+  return chunks;
+}
@@ -0,0 +1,72 @@
+#ifndef CSUDOKU_CORPUS_H
+#define CSUDOKU_CORPUS_H
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <sys/types.h>
+
+// Memory mapped puzzle corpus (one puzzle per line)
+//
+// Lines are returned as views into the mapping (not NUL terminated) so they
+// can be passed to CSudoku::loadGame(str, len) without copying. The mapped
+// range can be split on line boundaries into chunks for parallel workers.
+class CSudokuCorpus {
+ public:
+  // line of mapped file (without line ending)
+  struct Line {
+    const char *str { NULL };
+    size_t      len { 0 };
+  };
+
+  // range of whole lines of mapped file
+  class Chunk {
+   public:
+    Chunk(const char *begin=NULL, const char *end=NULL) :
+     begin_(begin), end_(end), pos_(begin) {
+    }
+
+    const char *begin() const { return begin_; }
+    const char *end  () const { return end_  ; }
+
+    size_t size() const { return size_t(end_ - begin_); }
+
+    // get next line skipping blank lines (returns false at end of chunk)
+    bool nextLine(Line &line);
+
+   private:
+    const char *begin_, *end_;
+    const char *pos_;
+  };
+
+ public:
+  CSudokuCorpus();
+ ~CSudokuCorpus();
+
+  CSudokuCorpus(const CSudokuCorpus &) = delete;
+  CSudokuCorpus &operator=(const CSudokuCorpus &) = delete;
+
+  bool open(const std::string &filename);
+  void close();
+
+  bool isOpen() const { return (fd_ >= 0); }
+
+  const char *getData() const { return data_; }
+  size_t      getSize() const { return size_; }
+
+  Chunk getChunk() const { return Chunk(data_, data_ + size_); }
+
+  // split into num_chunks chunks of about equal size
+  std::vector<Chunk> split(uint num_chunks) const;
+
+  // split into chunks of about chunk_size bytes
+  std::vector<Chunk> splitBySize(size_t chunk_size) const;
+
+ private:
+  int         fd_;
+  const char *data_;
+  size_t      size_;
+};
+
+#endif
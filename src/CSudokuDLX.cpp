@@ -0,0 +1,265 @@
+#include <CSudokuDLX.h>
+
+#include <cassert>
+
+CSudokuDLX::
+CSudokuDLX(uint cell_size) :
+ cell_size_(cell_size), size_(cell_size*cell_size), area_(size_*size_),
+ solution_(NULL), num_solutions_(0), limit_(1), num_nodes_(0), max_nodes_(0),
+ stopped_(false)
+{
+  num_cols_ = 4*area_;
+
+  uint num_rows  = size_*area_;
+  uint num_nodes = 1 + num_cols_ + 4*num_rows;
+
+  left_ .resize(num_nodes);
+  right_.resize(num_nodes);
+  up_   .resize(num_nodes);
+  down_ .resize(num_nodes);
+  col_  .resize(num_nodes);
+  row_  .resize(num_nodes);
+
+  col_size_.resize(num_cols_ + 1);
+  row_node_.resize(num_rows);
+
+  // root and column headers in a circular list
+  for (uint c = 0; c <= num_cols_; ++c) {
+    left_ [c] = int(c == 0 ? num_cols_ : c - 1);
+    right_[c] = int(c == num_cols_ ? 0 : c + 1);
+    up_   [c] = int(c);
+    down_ [c] = int(c);
+    col_  [c] = int(c);
+    row_  [c] = -1;
+
+    col_size_[c] = 0;
+  }
+
+  // candidate row for each value in each cell
+  for (uint k = 0; k < area_; ++k)
+    for (uint value = 1; value <= size_; ++value)
+      addRow(k, value);
+}
+
+void
+CSudokuDLX::
+addRow(uint k, uint value)
+{
+  uint i = k / size_;
+  uint j = k % size_;
+  uint b = (i / cell_size_) + cell_size_*(j / cell_size_);
+  uint v = value - 1;
+
+  int r = int(k*size_ + v);
+
+  // columns for cell, value in row, value in col and value in block
+  int cols[4] = {
+    int(1 +           k            ),
+    int(1 +   area_ + i*size_ + v),
+    int(1 + 2*area_ + j*size_ + v),
+    int(1 + 3*area_ + b*size_ + v)
+  };
+
+  int first = int(1 + num_cols_ + 4*uint(r));
+
+  row_node_[uint(r)] = first;
+
+  for (int n = 0; n < 4; ++n) {
+    int node = first + n;
+    int c    = cols[n];
+
+    // add to row (circular)
+    left_ [node] = (n == 0 ? first + 3 : node - 1);
+    right_[node] = (n == 3 ? first     : node + 1);
+
+    // add to bottom of column
+    up_  [node] = up_[c];
+    down_[node] = c;
+
+    down_[up_[c]] = node;
+    up_  [c]      = node;
+
+    col_[node] = c;
+    row_[node] = r;
+
+    ++col_size_[c];
+  }
+}
+
+uint
+CSudokuDLX::
+solve(const uint8_t *values, uint8_t *solution, uint limit, ulong max_nodes)
+{
+  solution_      = solution;
+  num_solutions_ = 0;
+  limit_         = (limit > 0 ? limit : 1);
+  num_nodes_     = 0;
+  max_nodes_     = max_nodes;
+  stopped_       = false;
+
+  solve_rows_.clear();
+
+  // select rows for initial values (fail if a column is already covered)
+  std::vector<int> init_rows;
+
+  bool valid = true;
+
+  for (uint k = 0; k < area_ && valid; ++k) {
+    uint value = values[k];
+
+    if (value == 0) continue;
+
+    assert(value <= size_);
+
+    int r    = int(k*size_ + value - 1);
+    int node = row_node_[uint(r)];
+
+    for (int n = 0; n < 4; ++n) {
+      int c = col_[node + n];
+
+      // column removed from header list if already covered
+      if (right_[left_[c]] != c)
+        valid = false;
+    }
+
+    if (! valid) break;
+
+    coverRow(r);
+
+    init_rows.push_back(r);
+  }
+
+  if (valid) {
+    if (solution_) {
+      for (uint k = 0; k < area_; ++k)
+        solution_[k] = values[k];
+    }
+
+    search();
+  }
+
+  // restore matrix
+  for (auto p = init_rows.rbegin(); p != init_rows.rend(); ++p)
+    uncoverRow(*p);
+
+  return num_solutions_;
+}
+
+void
+CSudokuDLX::
+cover(int c)
+{
+  right_[left_[c]] = right_[c];
+  left_[right_[c]] = left_[c];
+
+  for (int i = down_[c]; i != c; i = down_[i]) {
+    for (int j = right_[i]; j != i; j = right_[j]) {
+      down_[up_[j]] = down_[j];
+      up_[down_[j]] = up_[j];
+
+      --col_size_[col_[j]];
+    }
+  }
+}
+
+void
+CSudokuDLX::
+uncover(int c)
+{
+  for (int i = up_[c]; i != c; i = up_[i]) {
+    for (int j = left_[i]; j != i; j = left_[j]) {
+      ++col_size_[col_[j]];
+
+      down_[up_[j]] = j;
+      up_[down_[j]] = j;
+    }
+  }
+
+  right_[left_[c]] = c;
+  left_[right_[c]] = c;
+}
+
+void
+CSudokuDLX::
+coverRow(int r)
+{
+  int node = row_node_[uint(r)];
+
+  cover(col_[node]);
+
+  for (int j = right_[node]; j != node; j = right_[j])
+    cover(col_[j]);
+}
+
+void
+CSudokuDLX::
+uncoverRow(int r)
+{
+  int node = row_node_[uint(r)];
+
+  for (int j = left_[node]; j != node; j = left_[j])
+    uncover(col_[j]);
+
+  uncover(col_[node]);
+}
+
+bool
+CSudokuDLX::
+search()
+{
+  // all constraints satisfied so solution found
+  if (right_[0] == 0) {
+    if (num_solutions_ == 0 && solution_) {
+      for (auto r : solve_rows_)
+        solution_[uint(r) / size_] = uint8_t(uint(r) % size_ + 1);
+    }
+
+    ++num_solutions_;
+
+    return (num_solutions_ >= limit_);
+  }
+
+  // choose column with fewest candidate rows
+  int c        = right_[0];
+  int min_size = col_size_[c];
+
+  for (int c1 = right_[c]; c1 != 0 && min_size > 1; c1 = right_[c1]) {
+    if (col_size_[c1] < min_size) {
+      c        = c1;
+      min_size = col_size_[c1];
+    }
+  }
+
+  if (min_size == 0)
+    return false;
+
+  // try each candidate row in turn
+  bool done = false;
+
+  cover(c);
+
+  for (int r = down_[c]; r != c && ! done; r = down_[r]) {
+    if (max_nodes_ && num_nodes_ >= max_nodes_) {
+      stopped_ = true;
+      break;
+    }
+
+    ++num_nodes_;
+
+    solve_rows_.push_back(row_[r]);
+
+    for (int j = right_[r]; j != r; j = right_[j])
+      cover(col_[j]);
+
+    done = search();
+
+    for (int j = left_[r]; j != r; j = left_[j])
+      uncover(col_[j]);
+
+    solve_rows_.pop_back();
+  }
+
+  uncover(c);
+
+  return done;
+}
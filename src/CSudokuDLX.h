@@ -0,0 +1,64 @@
+#ifndef CSUDOKU_DLX_H
+#define CSUDOKU_DLX_H
+
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+// Dancing Links (Algorithm X) exact cover solver for sudoku grids
+//
+// The grid is modelled as 4*AREA constraint columns (each cell filled, each value
+// once per row, col and block) and SIZE*AREA candidate rows (value in cell). The
+// link matrix is built once and restored after each solve so it can be reused.
+class CSudokuDLX {
+ public:
+  CSudokuDLX(uint cell_size=3);
+
+  uint getSize() const { return size_; }
+  uint getArea() const { return area_; }
+
+  // solve grid of values (0 if unknown) stopping after limit solutions.
+  // Returns the number of solutions found and (if not NULL) sets solution to
+  // the first one. If max_nodes is not 0 the search also stops after trying
+  // that many candidate rows.
+  uint solve(const uint8_t *values, uint8_t *solution=NULL, uint limit=1,
+             ulong max_nodes=0);
+
+  // number of candidate rows tried by last solve
+  ulong getNumNodes() const { return num_nodes_; }
+
+  // check if last solve stopped at max_nodes before finishing (number of
+  // solutions is then a lower bound)
+  bool isStopped() const { return stopped_; }
+
+ private:
+  void addRow(uint k, uint value);
+
+  void cover  (int c);
+  void uncover(int c);
+
+  void coverRow  (int r);
+  void uncoverRow(int r);
+
+  bool search();
+
+ private:
+  uint             cell_size_, size_, area_;
+  uint             num_cols_;
+  std::vector<int> left_, right_, up_, down_; // node links (0 is root, then column headers)
+  std::vector<int> col_;                      // node column header
+  std::vector<int> row_;                      // node candidate row
+  std::vector<int> col_size_;                 // number of nodes in column
+  std::vector<int> row_node_;                 // first node of candidate row
+  std::vector<int> solve_rows_;               // candidate rows chosen by search
+  uint8_t         *solution_;
+  uint             num_solutions_;
+  uint             limit_;
+  ulong            num_nodes_;
+  ulong            max_nodes_;
+  bool             stopped_;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include <CSudokuEvents.h>
+
+#include <cstring>
+
+namespace {
+
+const char eventMagic[4] = { 'S', 'D', 'K', 'E' };
+
+}
+
+std::string
+CSudokuEvent::
+toString() const
+{
+  static const char *unitNames[] = { "Row", "Col", "Cell", "" };
+
+  std::string cell = "Cell (" + std::to_string(row) + "," + std::to_string(col) + ") ";
+  std::string in_unit = std::string(unitNames[unit_type & 3]) + " : " + cell;
+
+  switch (strategy) {
+    case SINGLE_VALUE:
+      return "Single Value " + std::to_string(value) + " for " + cell;
+    case UNIQUE_VALUE:
+      return "Unique Value " + std::to_string(value) + " for " + cell;
+    case TWIN_VALUES:
+      return "Twin Value for " + in_unit;
+    case TRIPLE_VALUES:
+      return "Triple Value for " + in_unit;
+    case QUAD_VALUES:
+      return "Quad Value for " + in_unit;
+    case HIDDEN_TWIN_VALUES:
+      return "Hidden Twin Value for " + in_unit;
+    case HIDDEN_TRIPLE_VALUES:
+      return "Hidden Triple Value for " + in_unit;
+    case HIDDEN_QUAD_VALUES:
+      return "Hidden Quad Value for " + in_unit;
+    case POINTING_VALUES:
+      return "Pointing Value for " + in_unit;
+    case CLAIMING_VALUES:
+      return "Claiming Value for " + in_unit;
+    case X_WING_VALUES:
+      return "X-Wing Value for " + in_unit;
+    case SWORDFISH_VALUES:
+      return "Swordfish Value for " + in_unit;
+    case JELLYFISH_VALUES:
+      return "Jellyfish Value for " + in_unit;
+    default:
+      return "Iterate solution";
+  }
+}
+
+//------
+
+void
+CSudokuTextEventSink::
+event(const CSudokuEvent &event)
+{
+  os_ << event.toString() << std::endl;
+}
+
+//------
+
+CSudokuRingEventSink::
+CSudokuRingEventSink(uint capacity) :
+ events_(capacity > 0 ? capacity : 1), num_events_(0)
+{
+}
+
+void
+CSudokuRingEventSink::
+event(const CSudokuEvent &event)
+{
+  events_[num_events_ % events_.size()] = event;
+
+  ++num_events_;
+}
+
+std::vector<CSudokuEvent>
+CSudokuRingEventSink::
+getEvents() const
+{
+  std::vector<CSudokuEvent> events;
+
+  ulong capacity = events_.size();
+  ulong start    = (num_events_ > capacity ? num_events_ - capacity : 0);
+
+  for (ulong i = start; i < num_events_; ++i)
+    events.push_back(events_[i % capacity]);
+
+  return events;
+}
+
+//------
+
+CSudokuBinaryEventSink::
+CSudokuBinaryEventSink() :
+ fp_(NULL)
+{
+}
+
+CSudokuBinaryEventSink::
+~CSudokuBinaryEventSink()
+{
+  close();
+}
+
+bool
+CSudokuBinaryEventSink::
+open(const std::string &filename)
+{
+  close();
+
+  fp_ = fopen(filename.c_str(), "wb");
+
+  if (! fp_)
+    return false;
+
+  uint8_t header[HEADER_SIZE] = {};
+
+  memcpy(header, eventMagic, 4);
+
+  header[4] = VERSION;
+  header[5] = RECORD_SIZE;
+
+  if (fwrite(header, 1, HEADER_SIZE, fp_) != HEADER_SIZE) {
+    fclose(fp_);
+
+    fp_ = NULL;
+
+    return false;
+  }
+
+  return true;
+}
+
+bool
+CSudokuBinaryEventSink::
+close()
+{
+  if (! fp_)
+    return true;
+
+  bool rc = (fclose(fp_) == 0);
+
+  fp_ = NULL;
+
+  return rc;
+}
+
+void
+CSudokuBinaryEventSink::
+event(const CSudokuEvent &event)
+{
+  if (! fp_)
+    return;
+
+  uint8_t record[RECORD_SIZE] = {
+    event.type, event.strategy, event.unit_type, event.unit,
+    event.row, event.col, event.value, 0,
+    uint8_t(event.mask), uint8_t(event.mask >> 8), uint8_t(event.mask >> 16),
+    uint8_t(event.mask >> 24)
+  };
+
+  fwrite(record, 1, RECORD_SIZE, fp_);
+}
+
+bool
+CSudokuBinaryEventSink::
+read(const std::string &filename, std::vector<CSudokuEvent> &events)
+{
+  events.clear();
+
+  FILE *fp = fopen(filename.c_str(), "rb");
+
+  if (! fp)
+    return false;
+
+  uint8_t header[HEADER_SIZE];
+
+  if (fread(header, 1, HEADER_SIZE, fp) != HEADER_SIZE ||
+      memcmp(header, eventMagic, 4) != 0 || header[4] != VERSION ||
+      header[5] != RECORD_SIZE) {
+    fclose(fp);
+    return false;
+  }
+
+  uint8_t record[RECORD_SIZE];
+
+  while (fread(record, 1, RECORD_SIZE, fp) == RECORD_SIZE) {
+    CSudokuEvent event;
+
+    event.type      = record[0];
+    event.strategy  = record[1];
+    event.unit_type = record[2];
+    event.unit      = record[3];
+    event.row       = record[4];
+    event.col       = record[5];
+    event.value     = record[6];
+    event.mask      = uint32_t(record[8]) | (uint32_t(record[9]) << 8) |
+                      (uint32_t(record[10]) << 16) | (uint32_t(record[11]) << 24);
+
+    events.push_back(event);
+  }
+
+  fclose(fp);
+
+  return true;
+}
@@ -0,0 +1,186 @@
+#ifndef CSUDOKU_EVENTS_H
+#define CSUDOKU_EVENTS_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+#include <cstdio>
+#include <sys/types.h>
+
+// solver deduction (reported to the board's event sink by solve() and
+// solveStep())
+struct CSudokuEvent {
+  enum Type {
+    PLACEMENT,   // value placed in cell
+    ELIMINATION, // possible values (mask) removed from other cells of unit
+    SEARCH       // no deduction found so backtracking search is used
+  };
+
+  // (new strategies are added at end to keep binary trace values)
+  enum Strategy {
+    SINGLE_VALUE,         // only possible value of cell
+    UNIQUE_VALUE,         // only cell of unit for value
+    TWIN_VALUES,          // two cells of unit with only two possible values
+    TRIPLE_VALUES,        // three cells of unit with only three possible values
+    ITERATE,              // backtracking
+    QUAD_VALUES,          // four cells of unit with only four possible values
+    HIDDEN_TWIN_VALUES,   // two values of unit only possible in two cells
+    HIDDEN_TRIPLE_VALUES, // three values of unit only possible in three cells
+    HIDDEN_QUAD_VALUES,   // four values of unit only possible in four cells
+    POINTING_VALUES,      // values of block only possible in one row/col
+    CLAIMING_VALUES,      // values of row/col only possible in one block
+    X_WING_VALUES,        // value of two rows/cols only possible in two cols/rows
+    SWORDFISH_VALUES,     // value of three rows/cols only possible in three cols/rows
+    JELLYFISH_VALUES      // value of four rows/cols only possible in four cols/rows
+  };
+
+  enum UnitType {
+    ROW,
+    COL,
+    BLOCK,
+    NO_UNIT
+  };
+
+  uint8_t  type      { SEARCH };
+  uint8_t  strategy  { ITERATE };
+  uint8_t  unit_type { NO_UNIT };
+  uint8_t  unit      { 0 };
+  uint8_t  row       { 0 };
+  uint8_t  col       { 0 };
+  uint8_t  value     { 0 };
+  uint32_t mask      { 0 };
+
+  static CSudokuEvent placement(Strategy strategy, uint row, uint col, uint value) {
+    CSudokuEvent event;
+
+    event.type     = PLACEMENT;
+    event.strategy = uint8_t(strategy);
+    event.row      = uint8_t(row);
+    event.col      = uint8_t(col);
+    event.value    = uint8_t(value);
+
+    return event;
+  }
+
+  static CSudokuEvent elimination(Strategy strategy, UnitType unit_type, uint unit,
+                                  uint row, uint col, uint mask) {
+    CSudokuEvent event;
+
+    event.type      = ELIMINATION;
+    event.strategy  = uint8_t(strategy);
+    event.unit_type = uint8_t(unit_type);
+    event.unit      = uint8_t(unit);
+    event.row       = uint8_t(row);
+    event.col       = uint8_t(col);
+    event.mask      = mask;
+
+    return event;
+  }
+
+  static CSudokuEvent search() { return CSudokuEvent(); }
+
+  // strategy of naked (values limited to cells) or hidden (cells limited to
+  // values) subset of 2-4 cells
+  static Strategy subsetStrategy(uint size, bool hidden) {
+    static const Strategy naked_strategies [] = {
+      TWIN_VALUES, TRIPLE_VALUES, QUAD_VALUES };
+    static const Strategy hidden_strategies[] = {
+      HIDDEN_TWIN_VALUES, HIDDEN_TRIPLE_VALUES, HIDDEN_QUAD_VALUES };
+
+    return (hidden ? hidden_strategies[size - 2] : naked_strategies[size - 2]);
+  }
+
+  // strategy of fish of 2-4 rows/cols
+  static Strategy fishStrategy(uint size) {
+    static const Strategy strategies[] = { X_WING_VALUES, SWORDFISH_VALUES, JELLYFISH_VALUES };
+
+    return strategies[size - 2];
+  }
+
+  // log message text
+  std::string toString() const;
+};
+
+//------
+
+// receiver of solver events
+class CSudokuEventSink {
+ public:
+  virtual ~CSudokuEventSink() { }
+
+  virtual void event(const CSudokuEvent &event) = 0;
+};
+
+//------
+
+// write events as log text lines
+class CSudokuTextEventSink : public CSudokuEventSink {
+ public:
+  CSudokuTextEventSink(std::ostream &os=std::cerr) :
+   os_(os) {
+  }
+
+  void event(const CSudokuEvent &event) override;
+
+ private:
+  std::ostream &os_;
+};
+
+//------
+
+// keep most recent events in fixed size buffer
+class CSudokuRingEventSink : public CSudokuEventSink {
+ public:
+  CSudokuRingEventSink(uint capacity=1024);
+
+  void event(const CSudokuEvent &event) override;
+
+  // number of events received (including those overwritten)
+  ulong getNumEvents() const { return num_events_; }
+
+  // buffered events (oldest first)
+  std::vector<CSudokuEvent> getEvents() const;
+
+  void clear() { num_events_ = 0; }
+
+ private:
+  std::vector<CSudokuEvent> events_;
+  ulong                     num_events_;
+};
+
+//------
+
+// write events to binary trace file
+//
+// Header (8 bytes): char[4] magic "SDKE", uint8 version (1), uint8 record size
+// (12), 2 reserved bytes. Record: uint8 type, strategy, unit type, unit, row,
+// col, value, reserved then uint32 mask (little endian).
+class CSudokuBinaryEventSink : public CSudokuEventSink {
+ public:
+  enum { HEADER_SIZE = 8  };
+  enum { VERSION     = 1  };
+  enum { RECORD_SIZE = 12 };
+
+  CSudokuBinaryEventSink();
+ ~CSudokuBinaryEventSink();
+
+  CSudokuBinaryEventSink(const CSudokuBinaryEventSink &) = delete;
+  CSudokuBinaryEventSink &operator=(const CSudokuBinaryEventSink &) = delete;
+
+  bool open(const std::string &filename);
+  bool close();
+
+  bool isOpen() const { return (fp_ != NULL); }
+
+  void event(const CSudokuEvent &event) override;
+
+  // read events from trace file
+  static bool read(const std::string &filename, std::vector<CSudokuEvent> &events);
+
+ private:
+  FILE *fp_;
+};
+
+#endif
@@ -0,0 +1,253 @@
+#include <CSudokuGenerator.h>
+
+#include <algorithm>
+#include <random>
+
+template<uint N>
+CSudokuGeneratorT<N>::
+CSudokuGeneratorT(uint64_t seed) :
+ base_uses_(1), num_base_uses_(0)
+{
+  setSeed(seed);
+}
+
+template<uint N>
+void
+CSudokuGeneratorT<N>::
+setSeed(uint64_t seed)
+{
+  if (seed == 0) {
+    std::random_device device;
+
+    seed = (uint64_t(device()) << 32) | device();
+  }
+
+  // mix seed (splitmix64) so nearby seeds give unrelated sequences (state must
+  // be non zero)
+  seed += 0x9E3779B97F4A7C15ULL;
+  seed  = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  seed  = (seed ^ (seed >> 27)) * 0x94D049BB133111EBULL;
+  seed ^= seed >> 31;
+
+  state_ = (seed ? seed : 1);
+
+  num_base_uses_ = 0;
+}
+
+template<uint N>
+void
+CSudokuGeneratorT<N>::
+genGrid(uint8_t *grid)
+{
+  // search new base grid when its shuffles are used up (restart search if it
+  // gets stuck)
+  if (num_base_uses_ == 0) {
+    while (! fillGrid(base_))
+      ;
+
+    num_base_uses_ = base_uses_;
+  }
+
+  --num_base_uses_;
+
+  for (uint k = 0; k < AREA; ++k)
+    grid[k] = base_[k];
+
+  shuffle(grid);
+}
+
+template<uint N>
+bool
+CSudokuGeneratorT<N>::
+fillGrid(uint8_t *grid)
+{
+  enum { ALL_MASK       = (1U << SIZE) - 1 };
+  enum { MAX_BACKTRACKS = 64*AREA };
+
+  Mask row_used[SIZE] = {}, col_used[SIZE] = {}, block_used[SIZE] = {};
+  Mask untried[AREA]; // values still to try for cell at depth
+  uint cells  [AREA]; // cell filled at depth
+
+  auto possibleValues = [&](uint k) {
+    uint i = k / SIZE;
+    uint j = k % SIZE;
+    uint b = (i / CELL_SIZE)*CELL_SIZE + j / CELL_SIZE;
+
+    return Mask(ALL_MASK & ~(row_used[i] | col_used[j] | block_used[b]));
+  };
+
+  // cells are filled in order for smaller grids. For 25x25 grids (where in
+  // order search gets stuck too often) the unknown cell with fewest possible
+  // values is filled next.
+  auto nextCell = [&](uint depth) {
+    if (N < 5)
+      return depth;
+
+    uint min_num = SIZE + 1;
+    uint min_k   = 0;
+
+    for (uint k = 0; k < AREA; ++k) {
+      if (grid[k]) continue;
+
+      uint num = uint(__builtin_popcount(possibleValues(k)));
+
+      if (num < min_num) {
+        min_num = num;
+        min_k   = k;
+
+        if (num <= 1) break;
+      }
+    }
+
+    return min_k;
+  };
+
+  auto setUsed = [&](uint k, Mask bit, bool used) {
+    uint i = k / SIZE;
+    uint j = k % SIZE;
+    uint b = (i / CELL_SIZE)*CELL_SIZE + j / CELL_SIZE;
+
+    if (used) {
+      row_used  [i] = Mask(row_used  [i] | bit);
+      col_used  [j] = Mask(col_used  [j] | bit);
+      block_used[b] = Mask(block_used[b] | bit);
+    }
+    else {
+      row_used  [i] = Mask(row_used  [i] & ~bit);
+      col_used  [j] = Mask(col_used  [j] & ~bit);
+      block_used[b] = Mask(block_used[b] & ~bit);
+    }
+  };
+
+  for (uint k = 0; k < AREA; ++k)
+    grid[k] = 0;
+
+  uint num_backtracks = 0;
+
+  uint depth = 0;
+
+  cells  [0] = nextCell(0);
+  untried[0] = possibleValues(cells[0]);
+
+  while (depth < AREA) {
+    // no values left so undo previous cell
+    if (! untried[depth]) {
+      if (depth == 0 || ++num_backtracks > MAX_BACKTRACKS)
+        return false;
+
+      --depth;
+
+      uint k = cells[depth];
+
+      setUsed(k, Mask(1U << (grid[k] - 1)), false);
+
+      grid[k] = 0;
+
+      continue;
+    }
+
+    // pick random untried value
+    Mask values = untried[depth];
+
+    for (uint r = random(uint(__builtin_popcount(values))); r > 0; --r)
+      values = Mask(values & (values - 1));
+
+    Mask bit = Mask(values & -values);
+
+    untried[depth] = Mask(untried[depth] & ~bit);
+
+    uint k = cells[depth];
+
+    grid[k] = uint8_t(__builtin_ctz(bit) + 1);
+
+    setUsed(k, bit, true);
+
+    ++depth;
+
+    if (depth < AREA) {
+      cells  [depth] = nextCell(depth);
+      untried[depth] = possibleValues(cells[depth]);
+    }
+  }
+
+  return true;
+}
+
+template<uint N>
+void
+CSudokuGeneratorT<N>::
+shuffle(uint8_t *grid)
+{
+  uint order[CELL_SIZE];
+  uint rows[SIZE], cols[SIZE];
+  uint values[SIZE + 1];
+
+  // rows: permute bands then rows within each band
+  for (uint n = 0; n < CELL_SIZE; ++n)
+    order[n] = n;
+
+  shuffleValues(order, CELL_SIZE);
+
+  for (uint n = 0; n < CELL_SIZE; ++n) {
+    uint *band = &rows[n*CELL_SIZE];
+
+    for (uint m = 0; m < CELL_SIZE; ++m)
+      band[m] = order[n]*CELL_SIZE + m;
+
+    shuffleValues(band, CELL_SIZE);
+  }
+
+  // cols: permute stacks then cols within each stack
+  shuffleValues(order, CELL_SIZE);
+
+  for (uint n = 0; n < CELL_SIZE; ++n) {
+    uint *stack = &cols[n*CELL_SIZE];
+
+    for (uint m = 0; m < CELL_SIZE; ++m)
+      stack[m] = order[n]*CELL_SIZE + m;
+
+    shuffleValues(stack, CELL_SIZE);
+  }
+
+  // relabel values (unknown 0 is unchanged)
+  values[0] = 0;
+
+  for (uint v = 1; v <= SIZE; ++v)
+    values[v] = v;
+
+  shuffleValues(&values[1], SIZE);
+
+  bool transpose = random(2);
+
+  uint8_t grid1[AREA];
+
+  for (uint i = 0; i < SIZE; ++i) {
+    for (uint j = 0; j < SIZE; ++j) {
+      uint k = (transpose ? cols[j]*SIZE + rows[i] : rows[i]*SIZE + cols[j]);
+
+      grid1[i*SIZE + j] = uint8_t(values[grid[k]]);
+    }
+  }
+
+  for (uint k = 0; k < AREA; ++k)
+    grid[k] = grid1[k];
+}
+
+template<uint N>
+void
+CSudokuGeneratorT<N>::
+shuffleValues(uint *values, uint n)
+{
+  // Fisher-Yates
+  for (uint i = n; i > 1; --i) {
+    uint j = random(i);
+
+    std::swap(values[i - 1], values[j]);
+  }
+}
+
+//------
+
+template class CSudokuGeneratorT<3>;
+template class CSudokuGeneratorT<4>;
+template class CSudokuGeneratorT<5>;
@@ -0,0 +1,77 @@
+#ifndef CSUDOKU_GENERATOR_H
+#define CSUDOKU_GENERATOR_H
+
+#include <algorithm>
+#include <type_traits>
+
+#include <cstdint>
+#include <sys/types.h>
+
+// random solved grid generator for grids with blocks of N x N cells
+//
+// A base grid is filled by backtracking over bit masks of the values used in
+// each row, col and block, trying each cell's possible values in random order.
+// Each generated grid is the base grid shuffled by a random validity preserving
+// symmetry (value relabelling, row/col permutations within bands/stacks,
+// band/stack permutations and transpose). By default a new base grid is
+// searched for every grid. setBaseUses(n) reuses each base grid for n grids so
+// search cost is shared, at the cost of n consecutive grids being symmetric
+// copies of each other.
+template<uint N>
+class CSudokuGeneratorT {
+ public:
+  enum { SIZE = N*N       };
+  enum { CELL_SIZE = N    };
+  enum { AREA = SIZE*SIZE };
+
+  typedef typename std::conditional<(SIZE <= 16), ushort, uint>::type Mask;
+
+  // seed 0 uses a seed from std::random_device
+  CSudokuGeneratorT(uint64_t seed=0);
+
+  void setSeed(uint64_t seed);
+
+  uint getBaseUses() const { return base_uses_; }
+  void setBaseUses(uint n) { base_uses_ = std::max(n, 1U); num_base_uses_ = 0; }
+
+  // fill grid with AREA values (1-SIZE) of a random solved grid
+  void genGrid(uint8_t *grid);
+
+  // fill grid with new random solved grid, not shuffled (returns false if the
+  // search gets stuck)
+  bool fillGrid(uint8_t *grid);
+
+  // apply random symmetry to solved (or partial) grid
+  void shuffle(uint8_t *grid);
+
+  // random shuffle of n values
+  void shuffleValues(uint *values, uint n);
+
+  // random integer in [0, n)
+  uint random(uint n) { return uint((uint64_t(next()) * n) >> 32); }
+
+ private:
+  // xorshift64* generator
+  uint32_t next() {
+    state_ ^= state_ >> 12;
+    state_ ^= state_ << 25;
+    state_ ^= state_ >> 27;
+
+    return uint32_t((state_ * 0x2545F4914F6CDD1DULL) >> 32);
+  }
+
+ private:
+  uint64_t state_;
+  uint8_t  base_[AREA];
+  uint     base_uses_;
+  uint     num_base_uses_;
+};
+
+// instantiated in CSudokuGenerator.cpp
+extern template class CSudokuGeneratorT<3>;
+extern template class CSudokuGeneratorT<4>;
+extern template class CSudokuGeneratorT<5>;
+
+typedef CSudokuGeneratorT<3> CSudokuGenerator;
+
+#endif
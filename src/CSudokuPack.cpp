@@ -0,0 +1,470 @@
+#include <CSudokuPack.h>
+
+#include <algorithm>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char packMagic[4] = { 'S', 'D', 'K', 'P' };
+
+void
+putUInt(uint8_t *data, uint64_t i, uint num_bytes)
+{
+  for (uint n = 0; n < num_bytes; ++n)
+    data[n] = uint8_t(i >> (8*n));
+}
+
+uint64_t
+getUInt(const uint8_t *data, uint num_bytes)
+{
+  uint64_t i = 0;
+
+  for (uint n = 0; n < num_bytes; ++n)
+    i |= uint64_t(data[n]) << (8*n);
+
+  return i;
+}
+
+// least significant bit first bit stream
+class BitWriter {
+ public:
+  BitWriter(std::vector<uint8_t> &data) :
+   data_(data) {
+  }
+
+ ~BitWriter() { flush(); }
+
+  void add(uint value, uint num_bits) {
+    bits_     |= uint64_t(value) << num_bits_;
+    num_bits_ += num_bits;
+
+    while (num_bits_ >= 8) {
+      data_.push_back(uint8_t(bits_));
+
+      bits_     >>= 8;
+      num_bits_  -= 8;
+    }
+  }
+
+  void flush() {
+    if (num_bits_ > 0)
+      data_.push_back(uint8_t(bits_));
+
+    bits_     = 0;
+    num_bits_ = 0;
+  }
+
+ private:
+  std::vector<uint8_t> &data_;
+  uint64_t              bits_     { 0 };
+  uint                  num_bits_ { 0 };
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t *data) :
+   data_(data) {
+  }
+
+  uint get(uint num_bits) {
+    while (num_bits_ < num_bits) {
+      bits_     |= uint64_t(*data_++) << num_bits_;
+      num_bits_ += 8;
+    }
+
+    uint value = uint(bits_ & ((1u << num_bits) - 1));
+
+    bits_     >>= num_bits;
+    num_bits_  -= num_bits;
+
+    return value;
+  }
+
+ private:
+  const uint8_t *data_;
+  uint64_t       bits_     { 0 };
+  uint           num_bits_ { 0 };
+};
+
+}
+
+//------
+
+CSudokuPack::
+CSudokuPack(uint cell_size, uint flags) :
+ cell_size_(cell_size), size_(cell_size*cell_size), area_(size_*size_), flags_(flags),
+ value_bits_(1)
+{
+  while ((1u << value_bits_) < size_)
+    ++value_bits_;
+}
+
+size_t
+CSudokuPack::
+recordSize(const uint8_t *mask) const
+{
+  uint num_values = 0;
+
+  if (hasSolutions())
+    num_values = area_;
+  else {
+    for (uint n = 0; n < getMaskBytes(); ++n)
+      num_values += uint(__builtin_popcount(mask[n]));
+  }
+
+  return getMaskBytes() + (hasDifficulty() ? 2 : 0) + (num_values*value_bits_ + 7)/8;
+}
+
+//------
+
+CSudokuPackWriter::
+CSudokuPackWriter() :
+ fp_(NULL), num_records_(0), offset_(0)
+{
+}
+
+CSudokuPackWriter::
+~CSudokuPackWriter()
+{
+  close();
+}
+
+bool
+CSudokuPackWriter::
+open(const std::string &filename, uint cell_size, uint flags)
+{
+  close();
+
+  if (cell_size < 2 || cell_size > 5)
+    return false;
+
+  fp_ = fopen(filename.c_str(), "wb");
+
+  if (! fp_)
+    return false;
+
+  *static_cast<CSudokuPack *>(this) = CSudokuPack(cell_size, flags);
+
+  num_records_ = 0;
+  offset_      = HEADER_SIZE;
+
+  index_.clear();
+
+  // header is written with record count and index offset on close
+  uint8_t header[HEADER_SIZE] = {};
+
+  if (fwrite(header, 1, HEADER_SIZE, fp_) != HEADER_SIZE) {
+    fclose(fp_);
+
+    fp_ = NULL;
+
+    return false;
+  }
+
+  return true;
+}
+
+bool
+CSudokuPackWriter::
+write(const uint8_t *values, const uint8_t *solution, uint difficulty)
+{
+  if (! fp_)
+    return false;
+
+  if (hasSolutions() && ! solution)
+    return false;
+
+  buffer_.clear();
+
+  buffer_.resize(getMaskBytes(), 0);
+
+  for (uint k = 0; k < area_; ++k) {
+    if (values[k] > size_)
+      return false;
+
+    if (values[k])
+      buffer_[k/8] = uint8_t(buffer_[k/8] | (1 << (k % 8)));
+  }
+
+  if (hasDifficulty()) {
+    uint8_t d[2];
+
+    putUInt(d, (difficulty < 0xFFFF ? difficulty : 0xFFFF), 2);
+
+    buffer_.push_back(d[0]);
+    buffer_.push_back(d[1]);
+  }
+
+  {
+    BitWriter bits(buffer_);
+
+    for (uint k = 0; k < area_; ++k)
+      if (values[k])
+        bits.add(values[k] - 1, value_bits_);
+
+    if (hasSolutions()) {
+      for (uint k = 0; k < area_; ++k) {
+        if (values[k]) continue;
+
+        if (solution[k] < 1 || solution[k] > size_)
+          return false;
+
+        bits.add(solution[k] - 1, value_bits_);
+      }
+    }
+  }
+
+  if (num_records_ % INDEX_STRIDE == 0)
+    index_.push_back(offset_);
+
+  if (fwrite(&buffer_[0], 1, buffer_.size(), fp_) != buffer_.size())
+    return false;
+
+  offset_ += buffer_.size();
+
+  ++num_records_;
+
+  return true;
+}
+
+bool
+CSudokuPackWriter::
+close()
+{
+  if (! fp_)
+    return true;
+
+  bool rc = true;
+
+  // index
+  std::vector<uint8_t> index(8*index_.size());
+
+  for (size_t i = 0; i < index_.size(); ++i)
+    putUInt(&index[8*i], index_[i], 8);
+
+  if (! index.empty() && fwrite(&index[0], 1, index.size(), fp_) != index.size())
+    rc = false;
+
+  // header
+  uint8_t header[HEADER_SIZE] = {};
+
+  memcpy(header, packMagic, 4);
+
+  header[4] = VERSION;
+  header[5] = uint8_t(cell_size_);
+  header[6] = uint8_t(flags_);
+
+  putUInt(&header[ 8], num_records_, 8);
+  putUInt(&header[16], offset_     , 8);
+  putUInt(&header[24], INDEX_STRIDE, 4);
+
+  if (fseek(fp_, 0, SEEK_SET) != 0 || fwrite(header, 1, HEADER_SIZE, fp_) != HEADER_SIZE)
+    rc = false;
+
+  if (fclose(fp_) != 0)
+    rc = false;
+
+  fp_ = NULL;
+
+  return rc;
+}
+
+//------
+
+CSudokuPackReader::
+CSudokuPackReader() :
+ fd_(-1), data_(NULL), file_size_(0), num_records_(0), index_stride_(INDEX_STRIDE),
+ index_(NULL)
+{
+}
+
+CSudokuPackReader::
+~CSudokuPackReader()
+{
+  close();
+}
+
+bool
+CSudokuPackReader::
+open(const std::string &filename)
+{
+  close();
+
+  fd_ = ::open(filename.c_str(), O_RDONLY);
+
+  if (fd_ < 0)
+    return false;
+
+  struct stat st;
+
+  if (fstat(fd_, &st) != 0 || size_t(st.st_size) < HEADER_SIZE) {
+    close();
+    return false;
+  }
+
+  file_size_ = size_t(st.st_size);
+
+  void *data = mmap(NULL, file_size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+
+  if (data == MAP_FAILED) {
+    data_ = NULL;
+
+    close();
+
+    return false;
+  }
+
+  data_ = static_cast<const uint8_t *>(data);
+
+  // check header
+  uint cell_size = data_[5];
+
+  if (memcmp(data_, packMagic, 4) != 0 || data_[4] != VERSION ||
+      cell_size < 2 || cell_size > 5) {
+    close();
+    return false;
+  }
+
+  *static_cast<CSudokuPack *>(this) = CSudokuPack(cell_size, data_[6]);
+
+  num_records_  = ulong(getUInt(&data_[ 8], 8));
+  index_stride_ = uint (getUInt(&data_[24], 4));
+
+  uint64_t index_offset = getUInt(&data_[16], 8);
+
+  uint64_t num_index = (index_stride_ ? (num_records_ + index_stride_ - 1)/index_stride_ : 0);
+
+  if (index_stride_ == 0 || index_offset < HEADER_SIZE || index_offset > file_size_ ||
+      num_index > (file_size_ - index_offset)/8) {
+    close();
+    return false;
+  }
+
+  index_ = data_ + index_offset;
+
+  return true;
+}
+
+void
+CSudokuPackReader::
+close()
+{
+  if (data_)
+    munmap(const_cast<uint8_t *>(data_), file_size_);
+
+  if (fd_ >= 0)
+    ::close(fd_);
+
+  fd_          = -1;
+  data_        = NULL;
+  file_size_   = 0;
+  num_records_ = 0;
+  index_       = NULL;
+}
+
+bool
+CSudokuPackReader::
+read(ulong i, uint8_t *values, uint8_t *solution, uint *difficulty) const
+{
+  Pos pos = getPos(i);
+
+  return readNext(pos, values, solution, difficulty);
+}
+
+CSudokuPackReader::Pos
+CSudokuPackReader::
+getPos(ulong i) const
+{
+  Pos pos;
+
+  if (i >= num_records_)
+    return pos;
+
+  // start at indexed record then skip records before i
+  ulong n = i/index_stride_;
+
+  pos.record = n*index_stride_;
+  pos.offset = size_t(getUInt(&index_[8*n], 8));
+
+  size_t index_offset = size_t(index_ - data_);
+
+  while (pos.record < i) {
+    if (pos.offset + getMaskBytes() > index_offset)
+      break;
+
+    pos.offset += recordSize(&data_[pos.offset]);
+
+    ++pos.record;
+  }
+
+  return pos;
+}
+
+bool
+CSudokuPackReader::
+readNext(Pos &pos, uint8_t *values, uint8_t *solution, uint *difficulty) const
+{
+  if (! data_ || pos.record >= num_records_)
+    return false;
+
+  size_t index_offset = size_t(index_ - data_);
+
+  if (pos.offset < HEADER_SIZE || pos.offset + getMaskBytes() > index_offset)
+    return false;
+
+  const uint8_t *mask = &data_[pos.offset];
+
+  size_t record_size = recordSize(mask);
+
+  if (pos.offset + record_size > index_offset)
+    return false;
+
+  const uint8_t *data = mask + getMaskBytes();
+
+  if (hasDifficulty()) {
+    if (difficulty)
+      *difficulty = uint(getUInt(data, 2));
+
+    data += 2;
+  }
+  else if (difficulty)
+    *difficulty = 0;
+
+  BitReader bits(data);
+
+  // value fields can hold values above size (record is corrupt)
+  uint max_value = 0;
+
+  for (uint k = 0; k < area_; ++k) {
+    values[k] = uint8_t((mask[k/8] & (1 << (k % 8))) ? bits.get(value_bits_) + 1 : 0);
+
+    max_value = std::max(max_value, uint(values[k]));
+  }
+
+  if (solution) {
+    if (hasSolutions()) {
+      for (uint k = 0; k < area_; ++k) {
+        solution[k] = (values[k] ? values[k] : uint8_t(bits.get(value_bits_) + 1));
+
+        max_value = std::max(max_value, uint(solution[k]));
+      }
+    }
+    else
+      memset(solution, 0, area_);
+  }
+
+  if (max_value > size_)
+    return false;
+
+  pos.offset += record_size;
+
+  ++pos.record;
+
+  return true;
+}
@@ -0,0 +1,140 @@
+#ifndef CSUDOKU_PACK_H
+#define CSUDOKU_PACK_H
+
+#include <string>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <sys/types.h>
+
+// Binary puzzle pack file
+//
+// Header (32 bytes, integers little endian):
+//   0  char[4] magic "SDKP"
+//   4  uint8   version (1)
+//   5  uint8   cell size (3 for 9x9, 4 for 16x16, 5 for 25x25)
+//   6  uint8   flags (HAS_SOLUTION, HAS_DIFFICULTY)
+//   7  uint8   reserved
+//   8  uint64  number of records
+//   16 uint64  index offset
+//   24 uint32  index stride
+//   28 uint32  reserved
+//
+// Record:
+//   given cell bitmap ((AREA + 7)/8 bytes, bit k set if cell k is given)
+//   uint16 difficulty (if HAS_DIFFICULTY)
+//   bit packed (value - 1) of each given cell then, if HAS_SOLUTION, of each
+//   unknown cell's solution, using the fewest bits which hold SIZE - 1 (4 bits
+//   for 9x9 and 16x16), padded to a byte
+//
+// Index: uint64 offset of every index stride'th record (records in between are
+// found by skipping, each record's size follows from its bitmap).
+class CSudokuPack {
+ public:
+  enum { HEADER_SIZE  = 32 };
+  enum { VERSION      = 1  };
+  enum { INDEX_STRIDE = 64 };
+
+  enum Flags {
+    HAS_SOLUTION   = (1<<0),
+    HAS_DIFFICULTY = (1<<1)
+  };
+
+  CSudokuPack(uint cell_size=3, uint flags=0);
+
+  uint getCellSize() const { return cell_size_; }
+  uint getSize    () const { return size_; }
+  uint getArea    () const { return area_; }
+  uint getFlags   () const { return flags_; }
+
+  bool hasSolutions () const { return (flags_ & HAS_SOLUTION  ); }
+  bool hasDifficulty() const { return (flags_ & HAS_DIFFICULTY); }
+
+  uint getMaskBytes() const { return (area_ + 7)/8; }
+  uint getValueBits() const { return value_bits_; }
+
+  // size of record with specified given cell bitmap
+  size_t recordSize(const uint8_t *mask) const;
+
+ protected:
+  uint cell_size_, size_, area_;
+  uint flags_;
+  uint value_bits_;
+};
+
+//------
+
+class CSudokuPackWriter : public CSudokuPack {
+ public:
+  CSudokuPackWriter();
+ ~CSudokuPackWriter();
+
+  CSudokuPackWriter(const CSudokuPackWriter &) = delete;
+  CSudokuPackWriter &operator=(const CSudokuPackWriter &) = delete;
+
+  bool open(const std::string &filename, uint cell_size=3, uint flags=0);
+
+  // add record of AREA values (0 if unknown). Solution (all values set) is
+  // needed if file has solutions.
+  bool write(const uint8_t *values, const uint8_t *solution=NULL, uint difficulty=0);
+
+  // write index and header
+  bool close();
+
+  ulong getNumRecords() const { return num_records_; }
+
+ private:
+  FILE                 *fp_;
+  ulong                 num_records_;
+  uint64_t              offset_;
+  std::vector<uint64_t> index_;
+  std::vector<uint8_t>  buffer_;
+};
+
+//------
+
+class CSudokuPackReader : public CSudokuPack {
+ public:
+  // read position (record number and offset of its data)
+  struct Pos {
+    ulong  record { 0 };
+    size_t offset { 0 };
+  };
+
+ public:
+  CSudokuPackReader();
+ ~CSudokuPackReader();
+
+  CSudokuPackReader(const CSudokuPackReader &) = delete;
+  CSudokuPackReader &operator=(const CSudokuPackReader &) = delete;
+
+  // map file (fails if not a valid pack file)
+  bool open(const std::string &filename);
+  void close();
+
+  bool isOpen() const { return (fd_ >= 0); }
+
+  ulong getNumRecords() const { return num_records_; }
+
+  // read record i into AREA values (0 if unknown) and, if not NULL and
+  // stored, its solution and difficulty (fails if the record is truncated or
+  // holds values above size)
+  bool read(ulong i, uint8_t *values, uint8_t *solution=NULL, uint *difficulty=NULL) const;
+
+  // position of record i (following records are then read in order by readNext)
+  Pos getPos(ulong i) const;
+
+  bool readNext(Pos &pos, uint8_t *values, uint8_t *solution=NULL, uint *difficulty=NULL) const;
+
+ private:
+  int             fd_;
+  const uint8_t  *data_;
+  size_t          file_size_;
+  ulong           num_records_;
+  uint            index_stride_;
+  const uint8_t  *index_;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CSUDOKU_RATING_H
+#define CSUDOKU_RATING_H
+
+// Puzzle difficulty rating (see CSudokuT::rate)
+//
+// The puzzle is solved using the weakest technique which makes progress at
+// each step (escalating only when all weaker ones are stuck). Each step adds
+// its technique's weight to the score. When no technique applies a guess
+// places the solution value in the cell with fewest possible values.
+
+#include <algorithm>
+
+#include <sys/types.h>
+
+class CSudokuRating {
+ public:
+  // techniques in order of difficulty
+  enum Technique {
+    NONE,                 // already solved
+    SINGLE_VALUE,         // only possible value of cell
+    UNIQUE_VALUE,         // only cell of unit for value
+    LOCKED_VALUES,        // values of block only in one row/col (or row/col in one block)
+    TWIN_VALUES,          // two cells of unit with only two possible values
+    HIDDEN_TWIN_VALUES,   // two values of unit only possible in two cells
+    TRIPLE_VALUES,        // three cells of unit with only three possible values
+    HIDDEN_TRIPLE_VALUES, // three values of unit only possible in three cells
+    QUAD_VALUES,          // four cells of unit with only four possible values
+    HIDDEN_QUAD_VALUES,   // four values of unit only possible in four cells
+    X_WING_VALUES,        // value of two rows/cols only possible in two cols/rows
+    SWORDFISH_VALUES,     // value of three rows/cols only possible in three cols/rows
+    JELLYFISH_VALUES,     // value of four rows/cols only possible in four cols/rows
+    GUESS,                // no technique applies
+    NUM_TECHNIQUES
+  };
+
+  static const char *techniqueName(Technique t) {
+    static const char *names[] = {
+      "none", "single_value", "unique_value", "locked_values", "twin_values",
+      "hidden_twin_values", "triple_values", "hidden_triple_values", "quad_values",
+      "hidden_quad_values", "x_wing_values", "swordfish_values", "jellyfish_values", "guess"
+    };
+
+    return names[t];
+  }
+
+  static uint techniqueWeight(Technique t) {
+    static const uint weights[] = { 0, 1, 2, 5, 10, 12, 20, 25, 30, 35, 40, 45, 50, 100 };
+
+    return weights[t];
+  }
+
+  // naked or hidden subset of 2-4 cells
+  static Technique subsetTechnique(uint size, bool hidden) {
+    return Technique(TWIN_VALUES + 2*(size - 2) + (hidden ? 1 : 0));
+  }
+
+  // fish of 2-4 rows/cols
+  static Technique fishTechnique(uint size) {
+    return Technique(X_WING_VALUES + (size - 2));
+  }
+
+  void addStep(Technique t, uint n=1) {
+    num_steps += n;
+
+    score += n*techniqueWeight(t);
+
+    hardest = std::max(hardest, t);
+
+    if (t == GUESS)
+      ++num_guesses;
+  }
+
+  // compare by hardest technique, then score
+  friend bool operator<(const CSudokuRating &r1, const CSudokuRating &r2) {
+    if (r1.hardest != r2.hardest)
+      return (r1.hardest < r2.hardest);
+
+    return (r1.score < r2.score);
+  }
+
+ public:
+  bool      solved      { false }; // false if puzzle has no solution
+  Technique hardest     { NONE };
+  uint      score       { 0 };
+  uint      num_guesses { 0 };
+  uint      num_steps   { 0 };
+};
+
+#endif
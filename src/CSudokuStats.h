@@ -0,0 +1,138 @@
+#ifndef CSUDOKU_STATS_H
+#define CSUDOKU_STATS_H
+
+// Solver statistics (only collected when built with CSUDOKU_STATS defined,
+// otherwise the CSUDOKU_STATS_* macros used by the solver expand to nothing)
+//
+// For each strategy: number of calls, calls which changed the board, cells
+// changed (value placed or possible values removed) and time spent. The
+// backtracking search also records nodes (values tried), backtracks (values
+// undone) and maximum depth.
+
+#include <algorithm>
+#include <chrono>
+
+#include <sys/types.h>
+
+class CSudokuStats {
+ public:
+  enum Strategy {
+    SOLVED_VALUES, // addSolvedValues
+    UNIQUE_VALUES, // checkUniqueValues
+    LOCKED_VALUES, // checkLockedValues
+    SUBSET_VALUES, // checkSubsetValues (all sizes, naked and hidden)
+    FISH_VALUES,   // checkFishValues (all sizes)
+    CHECK_VALID,   // checkValid
+    ITER_SOLVE,    // iterSolve (calls and time of outermost call only)
+    NUM_STRATEGIES
+  };
+
+  struct StrategyStats {
+    ulong  calls     { 0 };
+    ulong  successes { 0 };
+    ulong  changes   { 0 };
+    double seconds   { 0.0 };
+  };
+
+  struct SearchStats {
+    ulong nodes      { 0 };
+    ulong backtracks { 0 };
+    uint  max_depth  { 0 };
+  };
+
+  static const char *strategyName(Strategy s) {
+    static const char *names[] = {
+      "solved_values", "unique_values", "locked_values", "subset_values", "fish_values", "check_valid", "iter_solve"
+    };
+
+    return names[s];
+  }
+
+  const StrategyStats &strategy(Strategy s) const { return strategies[s]; }
+
+  void reset() { *this = CSudokuStats(); }
+
+  CSudokuStats &operator+=(const CSudokuStats &stats) {
+    for (uint s = 0; s < NUM_STRATEGIES; ++s) {
+      strategies[s].calls     += stats.strategies[s].calls;
+      strategies[s].successes += stats.strategies[s].successes;
+      strategies[s].changes   += stats.strategies[s].changes;
+      strategies[s].seconds   += stats.strategies[s].seconds;
+    }
+
+    search.nodes      += stats.search.nodes;
+    search.backtracks += stats.search.backtracks;
+    search.max_depth   = std::max(search.max_depth, stats.search.max_depth);
+
+    return *this;
+  }
+
+ public:
+  StrategyStats strategies[NUM_STRATEGIES];
+  SearchStats   search;
+};
+
+// count call and add time spent in scope to strategy
+class CSudokuStatsScope {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  CSudokuStatsScope(CSudokuStats::StrategyStats &stats, bool enabled=true) :
+   stats_(enabled ? &stats : NULL) {
+    if (! stats_) return;
+
+    ++stats_->calls;
+
+    start_ = Clock::now();
+  }
+
+ ~CSudokuStatsScope() {
+    if (stats_)
+      stats_->seconds += std::chrono::duration<double>(Clock::now() - start_).count();
+  }
+
+  CSudokuStatsScope(const CSudokuStatsScope &) = delete;
+  CSudokuStatsScope &operator=(const CSudokuStatsScope &) = delete;
+
+ private:
+  CSudokuStats::StrategyStats *stats_;
+  Clock::time_point            start_;
+};
+
+// track recursion depth in scope (and maximum depth reached)
+class CSudokuStatsDepth {
+ public:
+  CSudokuStatsDepth(uint &depth, uint &max_depth) :
+   depth_(depth) {
+    max_depth = std::max(max_depth, ++depth_);
+  }
+
+ ~CSudokuStatsDepth() { --depth_; }
+
+  CSudokuStatsDepth(const CSudokuStatsDepth &) = delete;
+  CSudokuStatsDepth &operator=(const CSudokuStatsDepth &) = delete;
+
+ private:
+  uint &depth_;
+};
+
+#ifdef CSUDOKU_STATS
+#define CSUDOKU_STATS_CALL(s) \
+  CSudokuStatsScope stats_scope(stats_.strategies[CSudokuStats::s])
+#define CSUDOKU_STATS_SUCCESS(s)    ++stats_.strategies[CSudokuStats::s].successes
+#define CSUDOKU_STATS_CHANGES(s, n) stats_.strategies[CSudokuStats::s].changes += (n)
+#define CSUDOKU_STATS_SEARCH(f)     ++stats_.search.f
+#define CSUDOKU_STATS_RESET()       resetStats()
+#define CSUDOKU_STATS_SEARCH_CALL() \
+  CSudokuStatsScope stats_scope(stats_.strategies[CSudokuStats::ITER_SOLVE], stats_depth_ == 0); \
+  CSudokuStatsDepth stats_depth(stats_depth_, stats_.search.max_depth)
+#else
+#define CSUDOKU_STATS_CALL(s)
+#define CSUDOKU_STATS_SUCCESS(s)    ((void) 0)
+#define CSUDOKU_STATS_CHANGES(s, n) ((void) 0)
+#define CSUDOKU_STATS_SEARCH(f)     ((void) 0)
+#define CSUDOKU_STATS_RESET()       ((void) 0)
+#define CSUDOKU_STATS_SEARCH_CALL()
+#endif
+
+#endif
@@ -0,0 +1,156 @@
+#include <CSudokuThreadPool.h>
+
+namespace {
+
+// pool and worker index of current thread (NULL if not a pool thread)
+thread_local CSudokuThreadPool *currentPool   = NULL;
+thread_local uint               currentWorker = 0;
+
+}
+
+CSudokuThreadPool::
+CSudokuThreadPool(uint num_threads) :
+ num_queued_(0), num_pending_(0), next_worker_(0), stop_(false)
+{
+  if (num_threads == 0)
+    num_threads = std::thread::hardware_concurrency();
+
+  if (num_threads == 0)
+    num_threads = 1;
+
+  // all workers must exist before any thread starts stealing
+  for (uint w = 0; w < num_threads; ++w)
+    workers_.push_back(std::unique_ptr<Worker>(new Worker));
+
+  threads_.reserve(num_threads);
+
+  for (uint w = 0; w < num_threads; ++w)
+    threads_.push_back(std::thread(&CSudokuThreadPool::run, this, w));
+}
+
+CSudokuThreadPool::
+~CSudokuThreadPool()
+{
+  wait();
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stop_ = true;
+  }
+
+  task_cond_.notify_all();
+
+  for (auto &thread : threads_)
+    thread.join();
+}
+
+void
+CSudokuThreadPool::
+submit(Task task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    ++num_pending_;
+
+    uint w = (currentPool == this ? currentWorker : next_worker_++ % getNumThreads());
+
+    // count task before it can be taken (taking it holds the deque's lock) so
+    // the queued count never drops below zero
+    std::lock_guard<std::mutex> worker_lock(workers_[w]->mutex);
+
+    workers_[w]->tasks.push_back(std::move(task));
+
+    ++num_queued_;
+  }
+
+  task_cond_.notify_one();
+}
+
+void
+CSudokuThreadPool::
+wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  done_cond_.wait(lock, [&]() { return num_pending_ == 0; });
+}
+
+void
+CSudokuThreadPool::
+run(uint w)
+{
+  currentPool   = this;
+  currentWorker = w;
+
+  Task task;
+
+  while (true) {
+    if (popTask(w, task) || stealTask(w, task)) {
+      --num_queued_;
+
+      task(w);
+
+      task = Task();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+
+      if (--num_pending_ == 0)
+        done_cond_.notify_all();
+
+      continue;
+    }
+
+    // sleep until a task is queued (queued count is only an estimate while a
+    // task is being taken so recheck the deques after waking)
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    task_cond_.wait(lock, [&]() { return stop_ || num_queued_ > 0; });
+
+    if (stop_)
+      break;
+  }
+}
+
+bool
+CSudokuThreadPool::
+popTask(uint w, Task &task)
+{
+  Worker &worker = *workers_[w];
+
+  std::lock_guard<std::mutex> lock(worker.mutex);
+
+  if (worker.tasks.empty())
+    return false;
+
+  task = std::move(worker.tasks.back());
+
+  worker.tasks.pop_back();
+
+  return true;
+}
+
+bool
+CSudokuThreadPool::
+stealTask(uint w, Task &task)
+{
+  uint num_threads = getNumThreads();
+
+  for (uint i = 1; i < num_threads; ++i) {
+    Worker &worker = *workers_[(w + i) % num_threads];
+
+    std::lock_guard<std::mutex> lock(worker.mutex);
+
+    if (worker.tasks.empty())
+      continue;
+
+    task = std::move(worker.tasks.front());
+
+    worker.tasks.pop_front();
+
+    return true;
+  }
+
+  return false;
+}
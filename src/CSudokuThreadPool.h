@@ -0,0 +1,64 @@
+#ifndef CSUDOKU_THREAD_POOL_H
+#define CSUDOKU_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/types.h>
+
+// Work stealing thread pool
+//
+// Each worker owns a deque of tasks. Tasks submitted from outside the pool are
+// spread over the workers, tasks submitted by a worker go on its own deque.
+// Workers take from the back of their own deque and, when it is empty, steal
+// from the front of the others. Tasks are passed the index of the worker
+// running them so per worker state (e.g. a board) can be indexed by it.
+class CSudokuThreadPool {
+ public:
+  typedef std::function<void (uint worker)> Task;
+
+ public:
+  // use one thread per core if num_threads is 0
+  CSudokuThreadPool(uint num_threads=0);
+ ~CSudokuThreadPool();
+
+  CSudokuThreadPool(const CSudokuThreadPool &) = delete;
+  CSudokuThreadPool &operator=(const CSudokuThreadPool &) = delete;
+
+  uint getNumThreads() const { return uint(workers_.size()); }
+
+  void submit(Task task);
+
+  // wait for all submitted tasks to finish
+  void wait();
+
+ private:
+  struct Worker {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+  };
+
+  void run(uint w);
+
+  bool popTask  (uint w, Task &task);
+  bool stealTask(uint w, Task &task);
+
+ private:
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread>             threads_;
+  std::mutex                           mutex_;       // taken before a worker mutex
+  std::condition_variable              task_cond_;   // task queued or stopping
+  std::condition_variable              done_cond_;   // all tasks finished
+  std::atomic<uint>                    num_queued_;  // tasks waiting in deques
+  uint                                 num_pending_; // tasks not yet finished
+  uint                                 next_worker_; // deque for next outside task
+  bool                                 stop_;
+};
+
+#endif